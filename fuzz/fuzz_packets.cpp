@@ -0,0 +1,62 @@
+// libFuzzer のファザー: 入力をクライアントから届いたバイト列としてサーバーの受信・ディスパッチ処理へ流す
+// ビルド: cmake -B build-fuzz -DCMAKE_CXX_COMPILER=clang++ -DPOT_BUILD_FUZZERS=ON && cmake --build build-fuzz --target fuzz_packets
+// 実行: ./build-fuzz/fuzz_packets corpus/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "core/headless.h"
+#include "core/server_config.h"
+#include "server_constants.h"
+
+volatile int g_running = 1;
+
+// 先頭1バイトで試合形式とコート面を選ぶ（残りがパケット列）
+static const char *const COURTS[] = {"hard", "clay", "grass"};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 1)
+        return 0;
+
+    ServerConfig config;
+    server_config_set_defaults(&config);
+    if (data[0] & 1)
+        server_config_set_value(&config, "mode", "doubles");
+    server_config_set_value(&config, "court", COURTS[(data[0] >> 1) % 3]);
+    server_config_finalize(&config);
+    data++;
+    size--;
+
+    HeadlessPacketStream stream;
+    if (!headless_packet_stream_begin(&stream, &config))
+        return 0;
+
+    // サーバーと同じく1tickに MAX_PACKETS_PER_CLIENT_PER_TICK 個まで処理する（端数は0で埋める）
+    Packet packets[MAX_PACKETS_PER_CLIENT_PER_TICK];
+    size_t offset = 0;
+    while (offset < size)
+    {
+        int count = 0;
+        while (count < MAX_PACKETS_PER_CLIENT_PER_TICK && offset < size)
+        {
+            size_t chunk = (size - offset < sizeof(Packet)) ? size - offset : sizeof(Packet);
+            memset(&packets[count], 0, sizeof(Packet));
+            memcpy(&packets[count], data + offset, chunk);
+            offset += chunk;
+            count++;
+        }
+        if (!headless_packet_stream_tick(&stream, packets, count))
+            break;
+    }
+
+    // 状態検査の失敗はクラッシュとして報告させる
+    if (stream.failure)
+    {
+        fprintf(stderr, "状態検査失敗: %s (パケット %lld, tick %lld)\n", stream.failure, stream.packets, stream.ticks);
+        abort();
+    }
+
+    headless_packet_stream_end(&stream);
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "admin_channel.h"
+#include <string.h>
+
+static_assert((ADMIN_COMMAND_QUEUE_SIZE & (ADMIN_COMMAND_QUEUE_SIZE - 1)) == 0,
+              "ADMIN_COMMAND_QUEUE_SIZE must be a power of two");
+
+void admin_snapshot_publish(AdminSnapshot *snapshot, const AdminMatchView *view)
+{
+    uint32_t sequence = __atomic_load_n(&snapshot->sequence, __ATOMIC_RELAXED);
+
+    // 奇数にしてから書き、書き終えたら次の偶数にする
+    __atomic_store_n(&snapshot->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&snapshot->view, view, sizeof(AdminMatchView));
+    __atomic_store_n(&snapshot->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+bool admin_snapshot_read(const AdminSnapshot *snapshot, AdminMatchView *view)
+{
+    for (int attempt = 0; attempt < ADMIN_SNAPSHOT_READ_ATTEMPTS; attempt++)
+    {
+        uint32_t before = __atomic_load_n(&snapshot->sequence, __ATOMIC_ACQUIRE);
+        if (before == 0)
+            return false;
+        if (before & 1u)
+            continue;
+
+        memcpy(view, &snapshot->view, sizeof(AdminMatchView));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&snapshot->sequence, __ATOMIC_RELAXED) == before)
+            return true;
+    }
+    return false;
+}
+
+bool admin_command_push(AdminCommandQueue *queue, const AdminCommand *command)
+{
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (tail - head >= (uint32_t)ADMIN_COMMAND_QUEUE_SIZE)
+        return false;
+
+    queue->commands[tail & (ADMIN_COMMAND_QUEUE_SIZE - 1)] = *command;
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool admin_command_pop(AdminCommandQueue *queue, AdminCommand *command)
+{
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head == tail)
+        return false;
+
+    *command = queue->commands[head & (ADMIN_COMMAND_QUEUE_SIZE - 1)];
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include "game/game_state.h"
+#include "game/match_stats.h"
+#include "../server_constants.h"
+
+// 管理スレッドとメインループの間の受け渡し
+// メインループは状態の写しを公開するだけで、管理スレッドを待つことはない
+
+// スロットごとの接続状態
+struct AdminSlotView
+{
+    bool connected;
+    bool ai;
+    bool suspended;           // 再接続待ち
+    float rtt_ms;
+    float jitter_ms;
+    float loss;
+    int snapshot_interval;       // スナップショットを何回に1回送っているか
+    uint32_t snapshots_skipped;  // 混雑で捨てたスナップショット（累計）
+    uint32_t packets_received;
+    uint32_t packets_deferred_ticks;  // 受信制限で読み残したtick数（累計）
+    uint32_t rejected_swings;         // 入力検査で捨てたスイング（累計）
+    uint32_t flagged_swings;          // 統計的に不自然なスイング（累計）
+};
+
+// 管理スレッドから見える試合の状態
+struct AdminMatchView
+{
+    bool in_match;       // false: 接続待ち（stateは前の試合か初期状態）
+    bool draining;
+    bool debug_log;
+    uint32_t server_tick;
+    uint32_t matches_started;
+    uint32_t rejected_accepts;  // 受付レート超過で閉じた接続（累計）
+    GameState state;
+    MatchStats stats;
+    AdminSlotView slots[MAX_CLIENTS];
+};
+
+// シーケンスロックで守った状態の写し（書き手はメインループだけ）
+// sequenceが奇数の間は書き込み中で、読み手は前後で同じ偶数が読めるまで読み直す
+struct AdminSnapshot
+{
+    uint32_t sequence;  // 0: 未公開
+    AdminMatchView view;
+};
+
+// 写しを公開する（メインループから呼ぶ、待たない）
+void admin_snapshot_publish(AdminSnapshot *snapshot, const AdminMatchView *view);
+
+// 最新の写しを読む（管理スレッドから呼ぶ）
+// 戻り値: 読めた場合true（未公開、または読み直しても書き込みと重なり続けた場合false）
+bool admin_snapshot_read(const AdminSnapshot *snapshot, AdminMatchView *view);
+
+// 管理ソケットからの操作（メインループで適用する）
+enum AdminCommandType
+{
+    ADMIN_COMMAND_SET_PHASE,      // value: GamePhase
+    ADMIN_COMMAND_KICK,           // value: スロット
+    ADMIN_COMMAND_SET_DEBUG_LOG,  // value: 0/1
+};
+
+struct AdminCommand
+{
+    AdminCommandType type;
+    int value;
+};
+
+// 単一生産者（管理スレッド）・単一消費者（メインループ）のリングバッファ
+struct AdminCommandQueue
+{
+    uint32_t head;  // 次に読む位置（消費者だけが書く）
+    uint32_t tail;  // 次に書く位置（生産者だけが書く）
+    AdminCommand commands[ADMIN_COMMAND_QUEUE_SIZE];
+};
+
+// 戻り値: 満杯ならfalse
+bool admin_command_push(AdminCommandQueue *queue, const AdminCommand *command);
+
+// 戻り値: 空ならfalse
+bool admin_command_pop(AdminCommandQueue *queue, AdminCommand *command);
@@ -0,0 +1,494 @@
+#include "admin_server.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "log.h"
+#include "server_context.h"
+#include "game/game_phase_manager.h"
+
+// 管理ソケットから指定できるフェーズ
+static const struct
+{
+    const char *name;
+    GamePhase phase;
+} ADMIN_PHASES[] = {
+    {"start_game", GAME_PHASE_START_GAME},
+    {"in_rally", GAME_PHASE_IN_RALLY},
+    {"point_scored", GAME_PHASE_POINT_SCORED},
+    {"match_complete", GAME_PHASE_MATCH_COMPLETE},
+    {"game_finished", GAME_PHASE_GAME_FINISHED},
+};
+static const int ADMIN_PHASE_COUNT = (int)(sizeof(ADMIN_PHASES) / sizeof(ADMIN_PHASES[0]));
+
+static const char *phase_name(GamePhase phase)
+{
+    if (phase == GAME_PHASE_WAIT_FOR_MATCH)
+        return "wait_for_match";
+    for (int i = 0; i < ADMIN_PHASE_COUNT; i++)
+    {
+        if (ADMIN_PHASES[i].phase == phase)
+            return ADMIN_PHASES[i].name;
+    }
+    return "unknown";
+}
+
+// ---- 管理スレッド側 ----
+
+// 応答を書き切る（相手が読まなければタイムアウトで諦める）
+static bool admin_write(int fd, const char *text, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = send(fd, text, length, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        text += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// 1行の要求に対する応答（複数行）を組み立てる
+struct AdminReply
+{
+    char text[8192];
+    size_t length;
+};
+
+static void reply_printf(AdminReply *reply, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void reply_printf(AdminReply *reply, const char *format, ...)
+{
+    if (reply->length >= sizeof(reply->text))
+        return;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(reply->text + reply->length, sizeof(reply->text) - reply->length, format, args);
+    va_end(args);
+    if (written > 0)
+        reply->length += (size_t)written;
+    if (reply->length > sizeof(reply->text))
+        reply->length = sizeof(reply->text);
+}
+
+static int count_view_players(const AdminMatchView *view)
+{
+    int count = 0;
+    for (int i = 0; i < view->state.player_count && i < MAX_CLIENTS; i++)
+    {
+        if (view->slots[i].connected)
+            count++;
+    }
+    return count;
+}
+
+static void reply_list(AdminReply *reply, const AdminMatchView *view)
+{
+    const GameState *state = &view->state;
+    if (!view->in_match)
+    {
+        reply_printf(reply, "match - waiting players=%d/%d%s\n", count_view_players(view), state->player_count,
+                     view->draining ? " draining" : "");
+        return;
+    }
+
+    const MatchScore *score = &state->score;
+    reply_printf(reply, "match 0 %s tick=%u players=%d/%d points=%d-%d games=%d-%d sets=%d-%d%s\n",
+                 phase_name(state->phase), view->server_tick, count_view_players(view), state->player_count,
+                 score->view.point_p1, score->view.point_p2, score->games[0], score->games[1],
+                 score->sets[0], score->sets[1], view->draining ? " draining" : "");
+}
+
+static void reply_dump(AdminReply *reply, const AdminMatchView *view)
+{
+    const GameState *state = &view->state;
+    const MatchScore *score = &state->score;
+
+    reply_printf(reply, "tick %u phase %s timer %.3f server %d winner %d debug_log %d rejected_accepts %u\n",
+                 view->server_tick, phase_name(state->phase), state->state_timer, state->server_player_id,
+                 state->match_winner, view->debug_log ? 1 : 0, view->rejected_accepts);
+    reply_printf(reply, "score points %d-%d games %d-%d sets %d-%d tiebreak %d-%d/%d\n",
+                 score->view.point_p1, score->view.point_p2, score->games[0], score->games[1],
+                 score->sets[0], score->sets[1], score->tiebreak_points[0], score->tiebreak_points[1],
+                 score->tiebreak_target);
+
+    const MatchStats *stats = &view->stats;
+    reply_printf(reply, "stats points %u-%u rallies %u rally_hits %u longest %u abilities %u\n",
+                 stats->points_won[0], stats->points_won[1], stats->rallies, stats->total_rally_hits,
+                 stats->longest_rally, stats->ability_changes);
+
+    for (int i = 0; i < state->ball_count && i < MAX_BALLS; i++)
+    {
+        const Ball *ball = &state->balls[i];
+        reply_printf(reply, "ball %d pos %.3f %.3f %.3f vel %.3f %.3f %.3f last_hit %d bounces %d hits %d\n",
+                     i, ball->point.x, ball->point.y, ball->point.z, ball->velocity.x, ball->velocity.y,
+                     ball->velocity.z, ball->last_hit_player_id, ball->bounce_count, ball->hit_count);
+    }
+
+    for (int i = 0; i < state->player_count && i < MAX_CLIENTS; i++)
+    {
+        const Player *player = &state->players[i];
+        const AdminSlotView *slot = &view->slots[i];
+        reply_printf(reply, "player %d %s pos %.3f %.3f %.3f rtt %.1f jitter %.1f loss %.2f snapshot 1/%d skipped %u "
+                     "packets %u deferred_ticks %u rejected_swings %u flagged_swings %u hits %u\n",
+                     i, !slot->connected ? "empty" : slot->ai ? "ai" : slot->suspended ? "suspended" : "remote",
+                     player->point.x, player->point.y, player->point.z, slot->rtt_ms, slot->jitter_ms, slot->loss,
+                     slot->snapshot_interval, slot->snapshots_skipped, slot->packets_received,
+                     slot->packets_deferred_ticks, slot->rejected_swings, slot->flagged_swings, view->stats.hits[i]);
+    }
+}
+
+// 操作を積んでメインループを起こす
+static void queue_command(AdminServer *admin, AdminReply *reply, AdminCommandType type, int value)
+{
+    AdminCommand command = { type, value };
+    if (!admin_command_push(&admin->commands, &command))
+    {
+        reply_printf(reply, "error: command queue full\n");
+        return;
+    }
+    event_loop_wake(admin->wake_fd);
+    reply_printf(reply, "ok\n");
+}
+
+static void handle_line(AdminServer *admin, char *line, AdminReply *reply)
+{
+    char *save = nullptr;
+    const char *command = strtok_r(line, " \t\r", &save);
+    const char *arg = strtok_r(nullptr, " \t\r", &save);
+    const char *arg2 = strtok_r(nullptr, " \t\r", &save);
+
+    if (!command)
+        return;
+
+    if (strcmp(command, "help") == 0)
+    {
+        reply_printf(reply, "list | dump | phase <name> | kick <slot> | log debug on|off\n");
+        reply_printf(reply, "phases:");
+        for (int i = 0; i < ADMIN_PHASE_COUNT; i++)
+            reply_printf(reply, " %s", ADMIN_PHASES[i].name);
+        reply_printf(reply, "\nok\n");
+        return;
+    }
+
+    if (strcmp(command, "list") == 0 || strcmp(command, "dump") == 0)
+    {
+        AdminMatchView view;
+        if (!admin_snapshot_read(&admin->snapshot, &view))
+        {
+            reply_printf(reply, "error: no snapshot\n");
+            return;
+        }
+        if (command[0] == 'l')
+            reply_list(reply, &view);
+        else
+            reply_dump(reply, &view);
+        reply_printf(reply, "ok\n");
+        return;
+    }
+
+    if (strcmp(command, "phase") == 0 && arg)
+    {
+        for (int i = 0; i < ADMIN_PHASE_COUNT; i++)
+        {
+            if (strcmp(arg, ADMIN_PHASES[i].name) == 0)
+            {
+                queue_command(admin, reply, ADMIN_COMMAND_SET_PHASE, (int)ADMIN_PHASES[i].phase);
+                return;
+            }
+        }
+        reply_printf(reply, "error: unknown phase %s\n", arg);
+        return;
+    }
+
+    if (strcmp(command, "kick") == 0 && arg)
+    {
+        char *end = nullptr;
+        long slot = strtol(arg, &end, 10);
+        if (*end != '\0' || slot < 0 || slot >= MAX_CLIENTS)
+        {
+            reply_printf(reply, "error: slot must be 0-%d\n", MAX_CLIENTS - 1);
+            return;
+        }
+        queue_command(admin, reply, ADMIN_COMMAND_KICK, (int)slot);
+        return;
+    }
+
+    if (strcmp(command, "log") == 0 && arg && arg2 && strcmp(arg, "debug") == 0)
+    {
+        if (strcmp(arg2, "on") == 0 || strcmp(arg2, "off") == 0)
+        {
+            queue_command(admin, reply, ADMIN_COMMAND_SET_DEBUG_LOG, arg2[1] == 'n' ? 1 : 0);
+            return;
+        }
+    }
+
+    reply_printf(reply, "error: unknown command (try help)\n");
+}
+
+// 1クライアントとのやり取り（切断・無通信・停止通知まで）
+static void serve_client(AdminServer *admin, int client_fd)
+{
+    char buffer[ADMIN_LINE_MAX];
+    size_t used = 0;
+
+    for (;;)
+    {
+        struct pollfd fds[2] = {
+            { client_fd, POLLIN, 0 },
+            { admin->stop_fd, POLLIN, 0 },
+        };
+        int ready = poll(fds, 2, ADMIN_CLIENT_TIMEOUT_MS);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready <= 0 || (fds[1].revents & POLLIN))
+            return;
+
+        ssize_t received = recv(client_fd, buffer + used, sizeof(buffer) - 1 - used, 0);
+        if (received <= 0)
+            return;
+        used += (size_t)received;
+
+        // 改行ごとに処理し、残りを先頭へ寄せる
+        char *start = buffer;
+        char *newline;
+        while ((newline = (char *)memchr(start, '\n', used - (size_t)(start - buffer))) != nullptr)
+        {
+            *newline = '\0';
+            AdminReply reply;
+            reply.length = 0;
+            handle_line(admin, start, &reply);
+            if (reply.length > 0 && !admin_write(client_fd, reply.text, reply.length))
+                return;
+            start = newline + 1;
+        }
+
+        used -= (size_t)(start - buffer);
+        memmove(buffer, start, used);
+
+        if (used >= sizeof(buffer) - 1)
+        {
+            const char error[] = "error: line too long\n";
+            admin_write(client_fd, error, sizeof(error) - 1);
+            return;
+        }
+    }
+}
+
+static void *admin_thread_main(void *arg)
+{
+    AdminServer *admin = (AdminServer *)arg;
+
+    for (;;)
+    {
+        struct pollfd fds[2] = {
+            { admin->listen_fd, POLLIN, 0 },
+            { admin->stop_fd, POLLIN, 0 },
+        };
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (fds[1].revents & POLLIN)
+            break;
+
+        int client_fd = accept4(admin->listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0)
+            continue;
+        serve_client(admin, client_fd);
+        close(client_fd);
+    }
+    return nullptr;
+}
+
+static void close_fds(AdminServer *admin)
+{
+    if (admin->listen_fd >= 0)
+    {
+        close(admin->listen_fd);
+        admin->listen_fd = -1;
+    }
+    if (admin->stop_fd >= 0)
+    {
+        close(admin->stop_fd);
+        admin->stop_fd = -1;
+    }
+}
+
+bool admin_server_start(AdminServer *admin, const char *path, int wake_fd)
+{
+    memset(admin, 0, sizeof(AdminServer));
+    admin->listen_fd = -1;
+    admin->stop_fd = -1;
+    admin->wake_fd = wake_fd;
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        LOG_ERROR("管理ソケットのパスが長すぎます: " << path);
+        return false;
+    }
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+    snprintf(admin->path, sizeof(admin->path), "%s", path);
+
+    admin->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    admin->stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (admin->listen_fd < 0 || admin->stop_fd < 0)
+    {
+        LOG_ERROR("管理ソケット作成失敗: " << strerror(errno));
+        close_fds(admin);
+        return false;
+    }
+
+    // 前のプロセスが残したソケットファイルは消して作り直す
+    unlink(path);
+
+    // 試合を操作できるので所有者だけが接続できるようにする
+    mode_t previous_mask = umask(0177);
+    int bound = bind(admin->listen_fd, (struct sockaddr *)&address, sizeof(address));
+    umask(previous_mask);
+
+    struct stat info;
+    if (bound < 0 || listen(admin->listen_fd, 4) < 0 || stat(path, &info) < 0)
+    {
+        LOG_ERROR("管理ソケットの待ち受け失敗: " << path << ": " << strerror(errno));
+        close_fds(admin);
+        return false;
+    }
+    admin->path_dev = info.st_dev;
+    admin->path_ino = info.st_ino;
+
+    if (pthread_create(&admin->thread, nullptr, admin_thread_main, admin) != 0)
+    {
+        LOG_ERROR("管理スレッドの起動失敗");
+        unlink(path);
+        close_fds(admin);
+        return false;
+    }
+    admin->started = true;
+
+    LOG_SUCCESS("管理ソケット: " << path);
+    return true;
+}
+
+void admin_server_stop(AdminServer *admin)
+{
+    if (!admin->started)
+        return;
+
+    uint64_t one = 1;
+    ssize_t written = write(admin->stop_fd, &one, sizeof(one));
+    (void)written;
+    pthread_join(admin->thread, nullptr);
+    admin->started = false;
+
+    // ホットリスタート後の新プロセスが同じパスに作り直したソケットは消さない
+    struct stat info;
+    if (stat(admin->path, &info) == 0 && info.st_dev == admin->path_dev && info.st_ino == admin->path_ino)
+        unlink(admin->path);
+
+    close_fds(admin);
+}
+
+// ---- メインループ側 ----
+
+static void kick_player(ServerContext *ctx, int slot)
+{
+    Player *player = &ctx->players[slot];
+    ClientConnection *connection = &ctx->connections[slot];
+    if (!player->connected)
+        return;
+
+    if (ctx->ai_players[slot].enabled)
+    {
+        ctx->ai_players[slot].enabled = false;
+        player->connected = false;
+    }
+    else
+    {
+        // 再接続も受け付けないようトークンを捨ててから閉じる
+        if (connection->socket)
+            event_loop_remove(&ctx->loop, connection->socket);
+        connection->session_token = 0;
+        connection->suspended = false;
+        network_close_client(player, connection);
+    }
+    LOG_WARN("管理ソケット: スロット " << slot << " を切断");
+}
+
+static void apply_command(ServerContext *ctx, const AdminCommand *command)
+{
+    switch (command->type)
+    {
+        case ADMIN_COMMAND_SET_PHASE:
+            set_game_phase(&ctx->state, (GamePhase)command->value);
+            LOG_WARN("管理ソケット: フェーズを " << phase_name(ctx->state.phase) << " に変更");
+            break;
+        case ADMIN_COMMAND_KICK:
+            kick_player(ctx, command->value);
+            break;
+        case ADMIN_COMMAND_SET_DEBUG_LOG:
+            g_debug_log_enabled = command->value != 0;
+            LOG_WARN("管理ソケット: デバッグログを有効化");
+            break;
+    }
+}
+
+static void publish_view(ServerContext *ctx)
+{
+    // 公開用の写しは大きいので毎回スタックに作らず静的領域を使う（メインループからのみ呼ぶ）
+    static AdminMatchView view;
+
+    view.in_match = ctx->state.phase != GAME_PHASE_WAIT_FOR_MATCH;
+    view.draining = ctx->draining;
+    view.debug_log = g_debug_log_enabled;
+    view.server_tick = ctx->server_tick;
+    view.rejected_accepts = ctx->rejected_accepts;
+    view.state = ctx->state;
+    view.stats = ctx->match_stats;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        const ClientConnection *connection = &ctx->connections[i];
+        AdminSlotView *slot = &view.slots[i];
+        slot->connected = ctx->players[i].connected;
+        slot->ai = ctx->ai_players[i].enabled;
+        slot->suspended = connection->suspended;
+        slot->rtt_ms = connection->link_quality.rtt_ms;
+        slot->jitter_ms = connection->link_quality.jitter_ms;
+        slot->loss = connection->link_quality.loss;
+        slot->snapshot_interval = connection->snapshot_pacer.interval;
+        slot->snapshots_skipped = connection->snapshot_pacer.skipped;
+        slot->packets_received = connection->packets_received;
+        slot->packets_deferred_ticks = connection->packets_deferred_ticks;
+        slot->rejected_swings = connection->input_validator.rejected_swings;
+        slot->flagged_swings = connection->input_validator.flagged_swings;
+    }
+
+    admin_snapshot_publish(&ctx->admin.snapshot, &view);
+}
+
+void admin_server_update(ServerContext *ctx)
+{
+    if (!ctx->admin.started)
+        return;
+
+    AdminCommand command;
+    while (admin_command_pop(&ctx->admin.commands, &command))
+        apply_command(ctx, &command);
+
+    publish_view(ctx);
+}
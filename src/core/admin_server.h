@@ -0,0 +1,35 @@
+#pragma once
+
+#include <pthread.h>
+#include <sys/types.h>
+#include "admin_channel.h"
+
+struct ServerContext;
+
+// 管理ソケット（Unixドメインソケット、1行1コマンドのテキスト）
+// 専用スレッドで受け付け、試合の状態はメインループが公開した写しだけを読む
+// 試合への操作はキューに積んでメインループに適用させる（メインループはロックを取らない）
+struct AdminServer
+{
+    bool started;
+    int listen_fd;
+    int stop_fd;       // 停止通知（eventfd）
+    int wake_fd;       // 操作を積んだらメインループを起こす
+    pthread_t thread;
+    char path[108];    // sockaddr_un.sun_path
+    dev_t path_dev;    // 自分が作ったソケットファイルか（ホットリスタート後に消さないため）
+    ino_t path_ino;
+
+    AdminSnapshot snapshot;
+    AdminCommandQueue commands;
+};
+
+// ソケットを作って管理スレッドを起動する
+// 戻り値: 成功時true
+bool admin_server_start(AdminServer *admin, const char *path, int wake_fd);
+
+// 管理スレッドを止めてソケットを消す（起動していなければ何もしない）
+void admin_server_stop(AdminServer *admin);
+
+// 管理ソケットからの操作を適用し、現在の状態を公開する（メインループ・待機ループの各周回で呼ぶ）
+void admin_server_update(ServerContext *ctx);
@@ -0,0 +1,161 @@
+#include "checkpoint.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include "log.h"
+
+#define CHECKPOINT_MAGIC 0x504F5443u  // "POTC"
+#define CHECKPOINT_LAYOUT_VERSION 3u
+#define CHECKPOINT_NO_SLOT 0xFFFFFFFFu
+
+// ロックを取った後でファイルを確保して共有マッピングする
+static bool checkpoint_map(CheckpointStore *store)
+{
+    if (ftruncate(store->fd, sizeof(CheckpointFile)) < 0)
+    {
+        LOG_ERROR("チェックポイントの確保失敗: " << strerror(errno));
+        return false;
+    }
+
+    void *memory = mmap(nullptr, sizeof(CheckpointFile), PROT_READ | PROT_WRITE, MAP_SHARED, store->fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        LOG_ERROR("チェックポイントのマッピング失敗: " << strerror(errno));
+        return false;
+    }
+
+    CheckpointFile *file = (CheckpointFile *)memory;
+    if (file->magic != CHECKPOINT_MAGIC || file->layout_version != CHECKPOINT_LAYOUT_VERSION ||
+        file->data_size != sizeof(CheckpointData))
+    {
+        // 新規作成・別ビルドのファイルは読まずに初期化する
+        memset(file, 0, sizeof(CheckpointFile));
+        file->magic = CHECKPOINT_MAGIC;
+        file->layout_version = CHECKPOINT_LAYOUT_VERSION;
+        file->data_size = sizeof(CheckpointData);
+        file->active = CHECKPOINT_NO_SLOT;
+    }
+
+    store->file = file;
+    for (int i = 0; i < 2; i++)
+    {
+        if (file->slots[i].sequence > store->sequence)
+            store->sequence = file->slots[i].sequence;
+    }
+    return true;
+}
+
+bool checkpoint_open(CheckpointStore *store, const char *path)
+{
+    store->fd = -1;
+    store->file = nullptr;
+    store->sequence = 0;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        LOG_ERROR("チェックポイントを開けません: " << path << ": " << strerror(errno));
+        return false;
+    }
+    store->fd = fd;
+
+    // ホットリスタート中は旧プロセスが試合を書き続けているので、ロックが取れるまで読み書きしない
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0)
+    {
+        if (errno != EWOULDBLOCK)
+        {
+            LOG_ERROR("チェックポイントのロック失敗: " << strerror(errno));
+            checkpoint_close(store);
+            return false;
+        }
+        LOG_WARN("チェックポイント: 別のプロセスが使用中のため、そのプロセスの終了後に引き継ぐ: " << path);
+        return true;
+    }
+
+    if (!checkpoint_map(store))
+    {
+        checkpoint_close(store);
+        return false;
+    }
+
+    LOG_SUCCESS("チェックポイント: " << path);
+    return true;
+}
+
+// 使用中だったファイルのロックが空いていれば引き継ぐ
+// 残っている試合は前のプロセスのもので、起動済みのこのプロセスでは再開できないので捨てる
+static bool checkpoint_try_lock(CheckpointStore *store)
+{
+    if (store->fd < 0 || flock(store->fd, LOCK_EX | LOCK_NB) < 0)
+        return false;
+
+    if (!checkpoint_map(store))
+    {
+        checkpoint_close(store);
+        return false;
+    }
+    __atomic_store_n(&store->file->active, CHECKPOINT_NO_SLOT, __ATOMIC_RELEASE);
+    LOG_INFO("チェックポイントを引き継ぎました");
+    return true;
+}
+
+void checkpoint_close(CheckpointStore *store)
+{
+    if (store->file)
+    {
+        munmap(store->file, sizeof(CheckpointFile));
+        store->file = nullptr;
+    }
+    if (store->fd >= 0)
+    {
+        close(store->fd);
+        store->fd = -1;
+    }
+}
+
+// 公開中でない方の面
+static uint32_t checkpoint_back_slot(const CheckpointFile *file)
+{
+    uint32_t active = __atomic_load_n(&file->active, __ATOMIC_ACQUIRE);
+    return (active == 0) ? 1u : 0u;
+}
+
+CheckpointData *checkpoint_begin(CheckpointStore *store)
+{
+    if (!store->file && !checkpoint_try_lock(store))
+        return nullptr;
+    return &store->file->slots[checkpoint_back_slot(store->file)].data;
+}
+
+void checkpoint_commit(CheckpointStore *store)
+{
+    if (!store->file)
+        return;
+
+    uint32_t back = checkpoint_back_slot(store->file);
+    store->file->slots[back].sequence = ++store->sequence;
+
+    // 面の内容を書き終えてから切り替える（途中で落ちても前の面が残る）
+    __atomic_store_n(&store->file->active, back, __ATOMIC_RELEASE);
+}
+
+const CheckpointData *checkpoint_latest(const CheckpointStore *store)
+{
+    if (!store->file)
+        return nullptr;
+
+    uint32_t active = __atomic_load_n(&store->file->active, __ATOMIC_ACQUIRE);
+    if (active > 1 || store->file->slots[active].sequence == 0)
+        return nullptr;
+    return &store->file->slots[active].data;
+}
+
+void checkpoint_clear(CheckpointStore *store)
+{
+    if (!store->file)
+        return;
+    __atomic_store_n(&store->file->active, CHECKPOINT_NO_SLOT, __ATOMIC_RELEASE);
+}
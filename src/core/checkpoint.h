@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include "game/game_state.h"
+#include "player/ai_player.h"
+
+// 試合再開に必要な状態一式（ソケットなどプロセス固有のものは含めない）
+struct CheckpointData
+{
+    GameState state;
+    AiPlayer ai_players[MAX_CLIENTS];
+    uint64_t session_tokens[MAX_CLIENTS];  // 0: 人間のプレイヤーなし
+    float ability_frame_time;
+    uint32_t server_tick;
+};
+
+// ファイル上の1面（sequenceは書き込みごとに増える）
+struct CheckpointSlot
+{
+    uint64_t sequence;
+    CheckpointData data;
+};
+
+// ファイル全体の並び（2面を交互に書き、書き終えた面をactiveで公開する）
+struct CheckpointFile
+{
+    uint32_t magic;
+    uint32_t layout_version;
+    uint32_t data_size;     // sizeof(CheckpointData)（ビルド間の不一致検出用）
+    uint32_t active;        // 最新の完全な面（CHECKPOINT_NO_SLOT: 試合なし）
+    CheckpointSlot slots[2];
+};
+
+// ファイルを共有マッピングしたチェックポイント
+// プロセスが落ちてもページキャッシュに残った最新の面から再開できる
+struct CheckpointStore
+{
+    int fd;                 // -1: 無効（開いている間は排他ロックを持つ）
+    CheckpointFile *file;   // NULL: 他のプロセスがロック中（読み書きしない）
+    uint64_t sequence;
+};
+
+// ファイルを開き、排他ロックを取って共有マッピングする（ヘッダーが合わなければ空で初期化）
+// ホットリスタート直後など別のプロセスがロック中なら、マッピングせずに成功を返す
+// （その間は最新の面を返さず書き込みもしない。ロックが空いた後の checkpoint_begin で引き継ぐ）
+// 戻り値: 成功時true
+bool checkpoint_open(CheckpointStore *store, const char *path);
+
+// 解放（ファイルの内容はそのまま残す）
+void checkpoint_close(CheckpointStore *store);
+
+// 書き込み先の面を返す（公開中の面には触れない。ロックが取れていなければNULL）
+// 呼び出し側は内容をすべて書いてから checkpoint_commit を呼ぶ
+CheckpointData *checkpoint_begin(CheckpointStore *store);
+
+// checkpoint_begin で書いた面を最新として公開する
+void checkpoint_commit(CheckpointStore *store);
+
+// 最新の面（なければNULL）
+const CheckpointData *checkpoint_latest(const CheckpointStore *store);
+
+// 試合なしにする（終了した試合を再開しないように）
+void checkpoint_clear(CheckpointStore *store);
@@ -0,0 +1,155 @@
+#include "event_loop.h"
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "log.h"
+#include "network/network.h"
+
+#define EVENT_LOOP_MAX_EVENTS 32
+
+bool event_loop_init(EventLoop *loop)
+{
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    loop->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (loop->epoll_fd < 0 || loop->timer_fd < 0 || loop->wake_fd < 0)
+    {
+        LOG_ERROR("イベントループ作成失敗: " << strerror(errno));
+        event_loop_shutdown(loop);
+        return false;
+    }
+
+    // timerfd・eventfdは自身のフィールドのアドレスで識別する
+    struct epoll_event timer_event = {};
+    timer_event.events = EPOLLIN;
+    timer_event.data.ptr = &loop->timer_fd;
+    struct epoll_event wake_event = {};
+    wake_event.events = EPOLLIN;
+    wake_event.data.ptr = &loop->wake_fd;
+
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->timer_fd, &timer_event) < 0 ||
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->wake_fd, &wake_event) < 0)
+    {
+        LOG_ERROR("イベントループ登録失敗: " << strerror(errno));
+        event_loop_shutdown(loop);
+        return false;
+    }
+    return true;
+}
+
+void event_loop_shutdown(EventLoop *loop)
+{
+    if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+    if (loop->timer_fd >= 0) close(loop->timer_fd);
+    if (loop->wake_fd >= 0) close(loop->wake_fd);
+    loop->epoll_fd = -1;
+    loop->timer_fd = -1;
+    loop->wake_fd = -1;
+}
+
+static bool event_loop_add(EventLoop *loop, TCPsocket socket, uint32_t events)
+{
+    int fd = network_get_socket_fd(socket);
+    if (fd < 0)
+        return false;
+
+    struct epoll_event event = {};
+    event.events = events;
+    event.data.ptr = socket;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        LOG_ERROR("ソケット登録失敗: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool event_loop_add_listener(EventLoop *loop, TCPsocket socket)
+{
+    return event_loop_add(loop, socket, EPOLLIN);
+}
+
+bool event_loop_add_client(EventLoop *loop, TCPsocket socket)
+{
+    return event_loop_add(loop, socket, EPOLLIN | EPOLLRDHUP | EPOLLET);
+}
+
+void event_loop_remove(EventLoop *loop, TCPsocket socket)
+{
+    int fd = network_get_socket_fd(socket);
+    if (fd >= 0)
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+static void event_loop_arm_timer(EventLoop *loop, uint64_t deadline_ns)
+{
+    struct itimerspec spec = {};
+    if (deadline_ns != EVENT_LOOP_NO_DEADLINE)
+    {
+        // 0は解除の意味になるため、過去の期限も最低1nsにする
+        if (deadline_ns == 0)
+            deadline_ns = 1;
+        spec.it_value.tv_sec = (time_t)(deadline_ns / 1000000000ULL);
+        spec.it_value.tv_nsec = (long)(deadline_ns % 1000000000ULL);
+    }
+    timerfd_settime(loop->timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+int event_loop_wait(EventLoop *loop, uint64_t deadline_ns)
+{
+    event_loop_arm_timer(loop, deadline_ns);
+
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    int count = epoll_wait(loop->epoll_fd, events, EVENT_LOOP_MAX_EVENTS, -1);
+    if (count < 0)
+    {
+        // シグナルによる中断はエラーにしない
+        if (errno == EINTR)
+            return 0;
+        LOG_ERROR("イベント待ち失敗: " << strerror(errno));
+        return -1;
+    }
+
+    int ready_sockets = 0;
+    for (int i = 0; i < count; i++)
+    {
+        void *ptr = events[i].data.ptr;
+        uint64_t value;
+
+        if (ptr == &loop->timer_fd)
+        {
+            while (read(loop->timer_fd, &value, sizeof(value)) > 0) {}
+        }
+        else if (ptr == &loop->wake_fd)
+        {
+            while (read(loop->wake_fd, &value, sizeof(value)) > 0) {}
+        }
+        else
+        {
+            ((SDLNet_GenericSocket)ptr)->ready = 1;
+            ready_sockets++;
+        }
+    }
+    return ready_sockets;
+}
+
+void event_loop_wake(int wake_fd)
+{
+    if (wake_fd < 0)
+        return;
+    uint64_t one = 1;
+    ssize_t written = write(wake_fd, &one, sizeof(one));
+    (void)written;
+}
+
+uint64_t event_loop_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
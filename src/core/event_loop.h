@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <SDL2/SDL_net.h>
+
+// 期限なし
+constexpr uint64_t EVENT_LOOP_NO_DEADLINE = UINT64_MAX;
+
+// epoll + timerfd + eventfd によるイベント待ち
+// ソケットの準備完了・期限到達・wakeのいずれかでのみ起床する
+struct EventLoop
+{
+    int epoll_fd;
+    int timer_fd;  // 次の期限（tick・フェーズ遷移）
+    int wake_fd;   // シグナルハンドラーなどからの起床通知
+};
+
+// 初期化（失敗時false）
+bool event_loop_init(EventLoop *loop);
+
+// 解放
+void event_loop_shutdown(EventLoop *loop);
+
+// リスナーを登録（レベルトリガー: 受け付け待ちがある間は毎回通知）
+bool event_loop_add_listener(EventLoop *loop, TCPsocket socket);
+
+// クライアントソケットを登録（エッジトリガー: 新しいデータの到着時のみ通知）
+// 読み残しは呼び出し側が受信バッファ量を見て処理する
+bool event_loop_add_client(EventLoop *loop, TCPsocket socket);
+
+// 登録解除
+void event_loop_remove(EventLoop *loop, TCPsocket socket);
+
+// 期限（CLOCK_MONOTONIC、ナノ秒）まで待つ
+// 準備完了したソケットにはSDLNet_SocketReadyが真になるよう印を付ける
+// 戻り値: 準備完了したソケット数、-1: エラー
+int event_loop_wait(EventLoop *loop, uint64_t deadline_ns);
+
+// 待機中のループを起こす（非同期シグナル安全）
+void event_loop_wake(int wake_fd);
+
+// 現在時刻（CLOCK_MONOTONIC、ナノ秒）
+uint64_t event_loop_now_ns();
@@ -1,151 +1,273 @@
 #include "game_update.h"
 #include <cstring>
+#include <cstddef>
+#include <type_traits>
 #include "log.h"
 #include "input_handler/input_handler.h"
 #include "physics/ball_physics.h"
 #include "game/score_logic.h"
 #include "game/game_phase_manager.h"
 #include "game/point_judge.h"
+#include "game/team.h"
 #include "common/ability.h"
-#include "common/ability_config.h"
+#include "game/ability_engine.h"
 #include "common/player_input.h"
 #include "common/player_swing.h"
 #include "common/game_constants.h"
-#include "server_broadcast.h"
+#include "server_session.h"
+#include "../server_constants.h"
 
-static void handle_point_scored(ServerContext *ctx, int winner_id)
+// winner_team: 得点したチーム（スコアのp1/p2はチーム単位）
+static void handle_point_scored(ServerContext *ctx, int winner_team)
 {
-    bool game_continues = add_point(&ctx->state.score, winner_id);
-    broadcast_score_update(ctx);
-    print_score(&ctx->state.score);
+    uint32_t events = add_point(&ctx->state.score, winner_team);
+    game_events_push(&ctx->state.events, GAME_EVENT_POINT_SCORED, ctx->state.balls[PRIMARY_BALL].last_hit_player_id,
+                     winner_team, events);
 
-    if (!game_continues)
+    if (events & SCORE_EVENT_MATCH)
     {
-        ctx->state.match_winner = winner_id;
+        ctx->state.match_winner = winner_team;
         set_game_phase(&ctx->state, GAME_PHASE_GAME_FINISHED);
         return;
     }
 
+    // ダブルスのチーム内のサーブ担当はゲームごとに交代する（ゲームの途中では同じプレイヤーが打つ）
+    if (events & SCORE_EVENT_GAME)
+    {
+        int players_per_team = ctx->state.player_count / TEAM_COUNT;
+        for (int team = 0; team < TEAM_COUNT; team++)
+            ctx->state.team_server_slot[team] = (ctx->state.team_server_slot[team] + 1) % players_per_team;
+    }
+
+    // 失点したチームがサーブする
     set_game_phase(&ctx->state, GAME_PHASE_START_GAME);
-    int next_server = GameConstants::get_opponent_player_id(winner_id);
-    reset_ball(&ctx->state.ball, next_server);
+    int serving_team = opponent_team(winner_team);
+    int next_server = team_player(serving_team, ctx->state.team_server_slot[serving_team]);
+    reset_ball(&ctx->state.balls[PRIMARY_BALL], next_server);
+    clear_decoy_balls(&ctx->state);
     ctx->state.server_player_id = next_server;
 }
 
-static void handle_ability_toggle(ServerContext *ctx, int player_id, const AbilityActivateRequest *request)
+// 受信データから bool・列挙型を直接読まない（範囲外の値を読み込むと未定義動作になる）
+// 整数のまま範囲を確かめ、問題なければ構造体へ写す
+static bool payload_bool_valid(const Packet *packet, size_t offset)
+{
+    return packet->data[offset] <= 1;
+}
+
+static bool decode_player_input(const Packet *packet, PlayerInput *input)
+{
+    if (!payload_bool_valid(packet, offsetof(PlayerInput, right)) ||
+        !payload_bool_valid(packet, offsetof(PlayerInput, left)) ||
+        !payload_bool_valid(packet, offsetof(PlayerInput, front)) ||
+        !payload_bool_valid(packet, offsetof(PlayerInput, back)))
+        return false;
+
+    memcpy(input, packet->data, sizeof(PlayerInput));
+    return true;
+}
+
+static bool decode_ability_request(const Packet *packet, AbilityActivateRequest *request)
+{
+    std::underlying_type<decltype(AbilityActivateRequest::ability_type)>::type raw_type;
+    std::underlying_type<decltype(AbilityActivateRequest::trigger)>::type raw_trigger;
+    memcpy(&raw_type, packet->data + offsetof(AbilityActivateRequest, ability_type), sizeof(raw_type));
+    memcpy(&raw_trigger, packet->data + offsetof(AbilityActivateRequest, trigger), sizeof(raw_trigger));
+
+    // 発動種別は即時かそれ以外の2値（0か1）のみ
+    if (!ability_engine_accepts_type((long long)raw_type) || (raw_trigger != 0 && raw_trigger != 1))
+        return false;
+
+    memcpy(request, packet->data, sizeof(AbilityActivateRequest));
+    return true;
+}
+
+static bool decode_player_swing(const Packet *packet, PlayerSwing *swing)
+{
+    typedef decltype(PlayerSwing::shot_type) ShotTypeField;
+    typedef typename std::conditional<std::is_enum<ShotTypeField>::value, std::underlying_type<ShotTypeField>,
+                                      std::common_type<ShotTypeField>>::type::type RawShotType;
+    RawShotType raw_shot_type;
+    memcpy(&raw_shot_type, packet->data + offsetof(PlayerSwing, shot_type), sizeof(raw_shot_type));
+    if (!input_handler_accepts_shot_type((long long)raw_shot_type))
+        return false;
+
+    memcpy(swing, packet->data, sizeof(PlayerSwing));
+    return true;
+}
+
+void game_dispatch_client_packet(ServerContext *ctx, int player_id, const Packet *packet, Uint32 now_ms)
 {
-    AbilityState *state = &ctx->state.ability_states[player_id];
-    state->player_id = player_id;
+    ClientConnection *connection = &ctx->connections[player_id];
+    PacketType pkt_type = (PacketType)packet->type;
 
-    if (request->trigger == TRIGGER_INSTANT)
+    // 通し番号つきの入力は、処理したものとして次の状態パケットで返す
+    if (pkt_type == PACKET_TYPE_PLAYER_INPUT || pkt_type == PACKET_TYPE_PLAYER_SWING)
     {
-        state->active_ability = request->ability_type;
-        state->remaining_frames = 1;
+        uint32_t sequence = network_input_sequence(packet);
+        if (sequence != 0)
+            connection->last_input_sequence = sequence;
     }
-    else
+
+    if (pkt_type == PACKET_TYPE_PLAYER_INPUT && packet->size == sizeof(PlayerInput))
+    {
+        PlayerInput input;
+        if (!decode_player_input(packet, &input))
+            return;
+
+        // 向きを変えるだけなので、入力を連打しても最高速度は超えない
+        apply_player_input(&ctx->state, player_id, &input);
+    }
+    else if (pkt_type == PACKET_TYPE_PLAYER_SWING && packet->size == sizeof(PlayerSwing))
     {
-        state->active_ability = ABILITY_NONE;
-        state->remaining_frames = 0;
+        PlayerSwing swing;
+        if (decode_player_swing(packet, &swing) &&
+            input_validator_check_swing(&connection->input_validator, &swing, now_ms))
+            apply_player_swing(&ctx->state, player_id, &swing);
+    }
+    else if (packet->type == PACKET_TYPE_PONG && packet->size == sizeof(PingPayload))
+    {
+        PingPayload pong;
+        memcpy(&pong, packet->data, sizeof(PingPayload));
+        link_quality_on_pong(&connection->link_quality, &pong, now_ms);
+    }
+    else if (pkt_type == PACKET_TYPE_ABILITY_REQUEST && packet->size == sizeof(AbilityActivateRequest))
+    {
+        AbilityActivateRequest request;
+        if (decode_ability_request(packet, &request) &&
+            ability_engine_activate(&ctx->state.ability_engine, ctx->state.ability_states, player_id, &request))
+            game_events_push(&ctx->state.events, GAME_EVENT_ABILITY_CHANGED, player_id, (int)request.ability_type, 0);
     }
-    broadcast_ability_state(ctx, player_id);
 }
 
-static void handle_ability_standard(ServerContext *ctx, int player_id, const AbilityActivateRequest *request)
+void game_handle_client_input(ServerContext *ctx)
 {
-    const AbilityConfig *config = ability_get_config(request->ability_type);
-    if (config == nullptr || !config->requires_server)
-        return;
+    Uint32 now_ms = SDL_GetTicks();
 
-    AbilityState *state = &ctx->state.ability_states[player_id];
-    state->player_id = player_id;
-    state->active_ability = request->ability_type;
-    state->remaining_frames = config->duration_frames;
-    broadcast_ability_state(ctx, player_id);
-}
-
-void game_handle_client_input(ServerContext *ctx, float dt)
-{
     for (int i = 0; i < MAX_CLIENTS; i++)
     {
         if (!ctx->players[i].connected || !ctx->connections[i].socket)
             continue;
 
-        while (SDLNet_SocketReady(ctx->connections[i].socket))
+        ClientConnection *connection = &ctx->connections[i];
+        int processed = 0;
+        connection->input_deferred = false;
+
+        while (SDLNet_SocketReady(connection->socket) ||
+               network_pending_bytes(connection->socket) >= (int)sizeof(Packet))
         {
+            // 上限を超えた分は読まずにカーネルバッファへ残す（TCPのフロー制御で送信側を抑える）
+            if (processed >= MAX_PACKETS_PER_CLIENT_PER_TICK ||
+                !rate_limiter_try_consume(&connection->input_limiter, now_ms))
+            {
+                connection->packets_deferred_ticks++;
+                connection->input_deferred = true;
+                break;
+            }
+
             Packet packet;
-            int size = network_receive_packet(ctx->connections[i].socket, &packet);
+            int size = network_receive_packet(connection->socket, &packet);
 
             if (size <= 0)
             {
                 LOG_WARN("クライアント " << i << " から切断されました");
-                SDLNet_TCP_DelSocket(ctx->socket_set, ctx->connections[i].socket);
-                network_close_client(&ctx->players[i], &ctx->connections[i]);
+                event_loop_remove(&ctx->loop, connection->socket);
+                session_suspend_client(ctx, i);
                 break;
             }
 
-            PacketType pkt_type = (PacketType)packet.type;
+            processed++;
+            connection->packets_received++;
 
-            if (pkt_type == PACKET_TYPE_PLAYER_INPUT && packet.size == sizeof(PlayerInput))
-            {
-                PlayerInput input;
-                memcpy(&input, packet.data, sizeof(PlayerInput));
-                apply_player_input(&ctx->state, i, &input, dt);
-
-                bool has_input = input.right || input.left || input.front || input.back;
-                if (has_input)
-                {
-                    Packet player_packet = create_packet_player_state(&ctx->state.players[i]);
-                    network_broadcast(ctx->players, ctx->connections, &player_packet);
-                }
-            }
-            else if (pkt_type == PACKET_TYPE_PLAYER_SWING && packet.size == sizeof(PlayerSwing))
-            {
-                PlayerSwing swing;
-                memcpy(&swing, packet.data, sizeof(PlayerSwing));
-                apply_player_swing(&ctx->state, i, &swing);
-            }
-            else if (pkt_type == PACKET_TYPE_ABILITY_REQUEST && packet.size == sizeof(AbilityActivateRequest))
-            {
-                AbilityActivateRequest request;
-                memcpy(&request, packet.data, sizeof(AbilityActivateRequest));
-
-                if (request.ability_type == ABILITY_GIANT || request.ability_type == ABILITY_CLONE)
-                    handle_ability_toggle(ctx, i, &request);
-                else
-                    handle_ability_standard(ctx, i, &request);
-            }
+            game_dispatch_client_packet(ctx, i, &packet, now_ms);
         }
     }
 }
 
+void game_update_ai_players(ServerContext *ctx, float dt)
+{
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        AiPlayer *ai = &ctx->ai_players[i];
+        if (!ai->enabled || !ctx->players[i].connected)
+            continue;
+
+        PlayerInput input;
+        PlayerSwing swing;
+        bool swing_requested = ai_player_think(ai, &ctx->state, i, dt, &input, &swing);
+
+        apply_player_input(&ctx->state, i, &input);
+
+        if (swing_requested)
+            apply_player_swing(&ctx->state, i, &swing);
+    }
+}
+
+void game_update_player_movement(ServerContext *ctx, float dt)
+{
+    // 送信はtick末尾でまとめて1回だけ行う
+    uint32_t moved = update_player_kinematics(&ctx->state, dt);
+    for (int i = 0; i < ctx->state.player_count; i++)
+    {
+        if (moved & (1u << i))
+            ctx->player_state_dirty[i] = true;
+    }
+}
+
+// ネット（白帯より下）に当たったか
+static bool hit_net(const Ball *ball)
+{
+    bool crossed_net = (ball->previous_z * ball->point.z < 0.0f) ||
+                       (ball->previous_z == GameConstants::NET_POSITION_Z) ||
+                       (ball->point.z == GameConstants::NET_POSITION_Z);
+    return crossed_net && ball->point.y <= GameConstants::NET_HEIGHT;
+}
+
+static_assert(MAX_BALLS <= 32, "bounce mask holds one bit per ball");
+
+// 分身はネットか最初のバウンドで消える（得点には関わらない）
+// 後ろから消すので、末尾から詰められるボールは判定済み
+static void update_decoy_balls(GameState *state, uint32_t bounced)
+{
+    for (int i = state->ball_count - 1; i > PRIMARY_BALL; i--)
+    {
+        if (hit_net(&state->balls[i]) || (bounced & (1u << i)))
+            remove_ball(state, i);
+    }
+}
+
 void game_update_physics_and_scoring(ServerContext *ctx, float dt)
 {
-    if (is_physics_active_phase(ctx->state.phase))
-        update_ball(&ctx->state.ball, dt);
+    GameState *state = &ctx->state;
+
+    // 積分とバウンドは試合開始時に選んだコート面の処理で全ボールまとめて行う
+    uint32_t bounced = 0;
+    if (is_physics_active_phase(state->phase))
+        bounced = ctx->court->step_balls(state->balls, state->ball_count, dt);
 
-    if (ctx->state.phase == GAME_PHASE_IN_RALLY)
+    if (state->ball_count > 1)
     {
-        Ball *ball = &ctx->state.ball;
+        // ラリー以外（得点後・サーブ待ち）には分身を残さない
+        if (state->phase == GAME_PHASE_IN_RALLY)
+            update_decoy_balls(state, bounced);
+        else
+            clear_decoy_balls(state);
+    }
 
-        bool crossed_net = (ball->previous_z * ball->point.z < 0.0f) ||
-                           (ball->previous_z == GameConstants::NET_POSITION_Z) ||
-                           (ball->point.z == GameConstants::NET_POSITION_Z);
+    Ball *ball = &state->balls[PRIMARY_BALL];
 
-        if (crossed_net && ball->point.y <= GameConstants::NET_HEIGHT)
-        {
-            int winner_id = GameConstants::get_opponent_player_id(ball->last_hit_player_id);
-            handle_point_scored(ctx, winner_id);
-            return;
-        }
+    if (state->phase == GAME_PHASE_IN_RALLY && hit_net(ball))
+    {
+        handle_point_scored(ctx, opponent_team(team_of(ball->last_hit_player_id)));
+        return;
     }
 
-    if (is_physics_active_phase(ctx->state.phase) &&
-        handle_bounce(&ctx->state.ball, GameConstants::GROUND_Y, GameConstants::BOUNCE_RESTITUTION))
+    if (bounced & (1u << PRIMARY_BALL))
     {
-        ctx->state.ball.bounce_count++;
+        ball->bounce_count++;
 
-        int winner_id = judge_point(&ctx->state);
-        if (winner_id != GameConstants::PLAYER_ID_INVALID)
-            handle_point_scored(ctx, winner_id);
+        int winner_team = judge_point(state);
+        if (winner_team != GameConstants::PLAYER_ID_INVALID)
+            handle_point_scored(ctx, winner_team);
     }
 }
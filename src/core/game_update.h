@@ -3,7 +3,16 @@
 #include "server_context.h"
 
 // クライアントからの入力を処理
-void game_handle_client_input(ServerContext *ctx, float dt);
+void game_handle_client_input(ServerContext *ctx);
+
+// 受信済みのパケット1つを処理（ヘッダーは network_validate_packet で確認済みであること）
+void game_dispatch_client_packet(ServerContext *ctx, int player_id, const Packet *packet, Uint32 now_ms);
+
+// AIプレイヤーの操作を決めて適用
+void game_update_ai_players(ServerContext *ctx, float dt);
+
+// プレイヤーの移動を進め、動いたプレイヤーを送信対象にする
+void game_update_player_movement(ServerContext *ctx, float dt);
 
 // ゲーム物理とスコアリングを更新
 void game_update_physics_and_scoring(ServerContext *ctx, float dt);
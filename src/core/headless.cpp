@@ -0,0 +1,311 @@
+#include "headless.h"
+#include "headless_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log.h"
+#include "server_context.h"
+#include "server_loop.h"
+#include "server_events.h"
+#include "server_init.h"
+#include "event_loop.h"
+#include "game_update.h"
+#include "game/game_phase_manager.h"
+#include "common/game_constants.h"
+#include "../server_constants.h"
+
+// 乱数化した試合の状態検査
+struct HeadlessFuzz
+{
+    bool enabled;
+    uint32_t rng;         // 試合ごとのAIの乱数・強さを決める（xorshift32）
+    const char *failure;  // 最初に見つかった不変条件違反（nullptr: なし）
+    int failed_match;
+    int failed_tick;
+};
+
+static uint32_t fuzz_next(HeadlessFuzz *fuzz)
+{
+    fuzz->rng ^= fuzz->rng << 13;
+    fuzz->rng ^= fuzz->rng >> 17;
+    fuzz->rng ^= fuzz->rng << 5;
+    return fuzz->rng;
+}
+
+// AIの乱数と強さを乱数化する（同じfuzz_seedなら同じ試合列になる）
+static void fuzz_ai_players(ServerContext *ctx, HeadlessFuzz *fuzz)
+{
+    int players = server_config_match_players(&ctx->config);
+    for (int i = 0; i < players; i++)
+    {
+        float skill = HEADLESS_FUZZ_MIN_SKILL +
+                      (1.0f - HEADLESS_FUZZ_MIN_SKILL) * (float)(fuzz_next(fuzz) & 0xffff) / 65535.0f;
+        uint32_t seed = fuzz_next(fuzz);
+        ai_player_init(&ctx->ai_players[i], skill, seed ? seed : 1u);
+    }
+}
+
+// 新しい試合を始める
+static void headless_start_match(ServerContext *ctx)
+{
+    init_game(&ctx->state, server_config_match_players(&ctx->config), &ctx->config.score_format, ctx->config.court_surface);
+    ctx->court = court_physics(ctx->state.surface);
+    init_phase_manager(&ctx->state);
+    set_game_phase(&ctx->state, GAME_PHASE_START_GAME);
+    ctx->ability_frame_time = 0.0f;
+}
+
+// 1試合を最後まで進める
+// 戻り値: 実行したtick数（打ち切り時は HEADLESS_MAX_TICKS_PER_MATCH、トレース不一致・検査失敗時はその時点まで）
+static int headless_play_match(ServerContext *ctx, float dt, int match, HeadlessTrace *trace, HeadlessFuzz *fuzz)
+{
+    headless_start_match(ctx);
+
+    int ticks = 0;
+    while (*(ctx->running) && ticks < HEADLESS_MAX_TICKS_PER_MATCH)
+    {
+        server_simulation_step(ctx, dt);
+        server_events_dispatch(ctx);
+        ticks++;
+
+        if (!headless_trace_tick(trace, match, ticks, &ctx->state))
+            break;
+
+        if (fuzz->enabled)
+        {
+            const char *failure = game_state_check_invariants(&ctx->state);
+            if (failure)
+            {
+                fuzz->failure = failure;
+                fuzz->failed_match = match;
+                fuzz->failed_tick = ticks;
+                break;
+            }
+        }
+    }
+    return ticks;
+}
+
+int headless_run_matches(const ServerConfig *config, const HeadlessOptions *options)
+{
+    const int match_count = options->match_count;
+
+    HeadlessTrace trace;
+    HeadlessTraceOpenResult trace_opened;
+    if (options->trace_verify_path)
+        trace_opened = headless_trace_open(&trace, HEADLESS_TRACE_VERIFY, options->trace_verify_path, config, match_count);
+    else if (options->trace_record_path)
+        trace_opened = headless_trace_open(&trace, HEADLESS_TRACE_RECORD, options->trace_record_path, config, match_count);
+    else
+        trace_opened = headless_trace_open(&trace, HEADLESS_TRACE_OFF, nullptr, config, match_count);
+    if (trace_opened == HEADLESS_TRACE_OTHER_BUILD)
+        return HEADLESS_EXIT_OTHER_BUILD;
+    if (trace_opened != HEADLESS_TRACE_OPENED)
+        return 1;
+
+    HeadlessFuzz fuzz = {};
+    fuzz.enabled = options->fuzz_seed != 0;
+    fuzz.rng = options->fuzz_seed;
+
+    // ServerContextは大きいのでヒープに置く（ソケット・イベントループは使わない）
+    ServerContext *ctx = (ServerContext *)calloc(1, sizeof(ServerContext));
+    if (!ctx)
+    {
+        LOG_ERROR("メモリ確保失敗");
+        headless_trace_close(&trace);
+        return 1;
+    }
+
+    ctx->config = *config;
+    ctx->config.ai_players = server_config_match_players(config);
+
+    volatile int running = 1;
+    ctx->running = &running;
+
+    const float dt = 1.0f / (float)config->simulation_hz;
+    int wins[TEAM_COUNT] = {};
+    int timeouts = 0;
+    int played = 0;
+    long long total_ticks = 0;
+
+    uint64_t start_ns = event_loop_now_ns();
+
+    for (int m = 0; m < match_count; m++)
+    {
+        running = 1;
+        server_fill_ai_slots(ctx, (uint32_t)m + 1u);
+        if (fuzz.enabled)
+            fuzz_ai_players(ctx, &fuzz);
+
+        total_ticks += headless_play_match(ctx, dt, m, &trace, &fuzz);
+        played++;
+        if (trace.diverged || fuzz.failure)
+            break;
+
+        if (running)
+            timeouts++;
+        else if (ctx->state.match_winner >= 0 && ctx->state.match_winner < TEAM_COUNT)
+            wins[ctx->state.match_winner]++;
+    }
+
+    double elapsed_sec = (double)(event_loop_now_ns() - start_ns) / 1e9;
+
+    printf("Headless: %d matches, %lld ticks, %.3f s (%.1f matches/s, %.1f ns/tick)\n",
+           played, total_ticks, elapsed_sec,
+           elapsed_sec > 0.0 ? played / elapsed_sec : 0.0,
+           total_ticks > 0 ? elapsed_sec * 1e9 / (double)total_ticks : 0.0);
+    for (int i = 0; i < TEAM_COUNT; i++)
+        printf("  %s%d wins: %d\n", config->doubles ? "Team" : "Player", i + 1, wins[i]);
+    printf("  Timeouts: %d\n", timeouts);
+
+    int exit_code = 0;
+    bool trace_ok = headless_trace_close(&trace);
+    if (options->trace_verify_path)
+    {
+        printf("  Trace: %s (%lld ticks checked)\n", trace_ok ? "match" : "DIVERGED", trace.ticks_checked);
+        if (!trace_ok)
+            exit_code = 1;
+    }
+    else if (options->trace_record_path)
+    {
+        printf("  Trace: recorded %lld ticks to %s\n", trace.ticks_checked, options->trace_record_path);
+    }
+
+    if (fuzz.failure)
+    {
+        // 同じシードで再実行すれば同じ試合で再現する
+        LOG_ERROR("状態検査失敗: " << fuzz.failure << " (fuzz seed " << options->fuzz_seed
+                  << ", 試合 " << fuzz.failed_match << " tick " << fuzz.failed_tick << ")");
+        exit_code = 1;
+    }
+    else if (fuzz.enabled)
+    {
+        printf("  Fuzz: seed %u, invariants held\n", options->fuzz_seed);
+    }
+
+    free(ctx);
+    return exit_code;
+}
+
+bool headless_packet_stream_begin(HeadlessPacketStream *stream, const ServerConfig *config)
+{
+    memset(stream, 0, sizeof(HeadlessPacketStream));
+    ServerContext *ctx = (ServerContext *)calloc(1, sizeof(ServerContext));
+    if (!ctx)
+    {
+        LOG_ERROR("メモリ確保失敗");
+        return false;
+    }
+    stream->ctx = ctx;
+
+    // スロット0を受信側のクライアントにし、残りをAIで埋める（ソケットは持たない）
+    ctx->config = *config;
+    ctx->config.ai_players = server_config_match_players(config) - 1;
+
+    stream->running = 1;
+    ctx->running = &stream->running;
+
+    server_fill_ai_slots(ctx, 1u);
+    ctx->players[0].connected = true;
+    ctx->players[0].player_id = 0;
+    ctx->connections[0].player_id = 0;
+    input_validator_init(&ctx->connections[0].input_validator, 0);
+    link_quality_init(&ctx->connections[0].link_quality);
+    headless_start_match(ctx);
+
+    stream->dt = 1.0f / (float)config->simulation_hz;
+    return true;
+}
+
+bool headless_packet_stream_tick(HeadlessPacketStream *stream, const Packet *packets, int count)
+{
+    ServerContext *ctx = stream->ctx;
+    for (int n = 0; n < count; n++)
+    {
+        stream->packets++;
+
+        // サーバーは不正なヘッダーを受け取ると切断する
+        if (!network_validate_packet(&packets[n]))
+        {
+            stream->disconnected = true;
+            return false;
+        }
+        game_dispatch_client_packet(ctx, 0, &packets[n], stream->now_ms);
+    }
+
+    server_simulation_step(ctx, stream->dt);
+    server_events_dispatch(ctx);
+    stream->ticks++;
+    // 時刻はtick数から決める（同じ入力なら毎回同じ結果になる）
+    stream->now_ms = (Uint32)(stream->ticks * 1000 / ctx->config.simulation_hz);
+
+    stream->failure = game_state_check_invariants(&ctx->state);
+
+    if (!stream->running)
+    {
+        stream->running = 1;
+        headless_start_match(ctx);
+    }
+    return stream->failure == nullptr;
+}
+
+void headless_packet_stream_end(HeadlessPacketStream *stream)
+{
+    free(stream->ctx);
+    stream->ctx = nullptr;
+}
+
+int headless_run_packet_stream(const ServerConfig *config, const char *path)
+{
+    bool from_stdin = strcmp(path, "-") == 0;
+    FILE *file = from_stdin ? stdin : fopen(path, "rb");
+    if (!file)
+    {
+        LOG_ERROR("パケット列を開けません: " << path);
+        return 1;
+    }
+
+    HeadlessPacketStream stream;
+    if (!headless_packet_stream_begin(&stream, config))
+    {
+        if (!from_stdin)
+            fclose(file);
+        return 1;
+    }
+
+    // サーバーと同じく1tickに MAX_PACKETS_PER_CLIENT_PER_TICK 個まで処理する
+    Packet packets[MAX_PACKETS_PER_CLIENT_PER_TICK];
+    bool end_of_stream = false;
+    while (!end_of_stream)
+    {
+        int count = 0;
+        while (count < MAX_PACKETS_PER_CLIENT_PER_TICK)
+        {
+            memset(&packets[count], 0, sizeof(Packet));
+            if (fread(&packets[count], 1, sizeof(Packet), file) < sizeof(Packet))
+            {
+                end_of_stream = true;
+                break;
+            }
+            count++;
+        }
+        if (!headless_packet_stream_tick(&stream, packets, count))
+            break;
+    }
+
+    if (!from_stdin)
+        fclose(file);
+
+    printf("Packet stream: %lld packets, %lld ticks%s\n", stream.packets, stream.ticks,
+           stream.disconnected ? " (disconnected on invalid header)" : "");
+
+    int exit_code = 0;
+    if (stream.failure)
+    {
+        LOG_ERROR("状態検査失敗: " << stream.failure << " (パケット " << stream.packets << ", tick " << stream.ticks << ")");
+        exit_code = 1;
+    }
+
+    headless_packet_stream_end(&stream);
+    return exit_code;
+}
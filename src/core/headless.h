@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include "server_config.h"
+#include "network/network.h"
+
+struct ServerContext;
+
+// ヘッドレス実行の指定
+struct HeadlessOptions
+{
+    int match_count;                // 実行する試合数
+    const char *trace_record_path;  // 毎tickの状態ハッシュを書き出すファイル（nullptr: 書き出さない）
+    const char *trace_verify_path;  // 書き出し済みのトレースと毎tick照合するファイル（nullptr: 照合しない）
+    uint32_t fuzz_seed;             // 0以外: AIの乱数と強さを試合ごとに乱数化し、毎tick状態を検査する
+};
+
+// AI同士の試合をネットワークなしで連続実行する（負荷試験・長時間試験・回帰確認用）
+// 戻り値: プロセスの終了コード（トレース不一致・状態検査の失敗は1、トレースが別ビルドで記録されていれば HEADLESS_EXIT_OTHER_BUILD）
+int headless_run_matches(const ServerConfig *config, const HeadlessOptions *options);
+
+// 受信したバイト列をファイル（"-": 標準入力）から読み、サーバーの受信・ディスパッチ処理へ流す
+// スロット0のクライアントとして扱い、1tickごとに状態を検査する（ファザーやサニタイザーと組み合わせて使う）
+// 戻り値: プロセスの終了コード（状態検査の失敗は1）
+int headless_run_packet_stream(const ServerConfig *config, const char *path);
+
+// パケット列を流し込む試合（headless_run_packet_stream と、バイト列を直接渡すファザーが使う）
+struct HeadlessPacketStream
+{
+    ServerContext *ctx;
+    volatile int running;
+    float dt;
+    Uint32 now_ms;       // tick数から決める（同じ入力なら毎回同じ結果になる）
+    long long ticks;
+    long long packets;
+    const char *failure;  // 状態検査の失敗（nullptr: なし）
+    bool disconnected;    // 不正なヘッダーで切断した
+};
+
+// 戻り値: 成功時true
+bool headless_packet_stream_begin(HeadlessPacketStream *stream, const ServerConfig *config);
+
+// 1tick分のパケット（サーバーと同じく最大 MAX_PACKETS_PER_CLIENT_PER_TICK 個）を処理してから1tick進める
+// 戻り値: 続けられるならtrue（不正なヘッダーで切断したか状態検査に失敗したらfalse）
+bool headless_packet_stream_tick(HeadlessPacketStream *stream, const Packet *packets, int count);
+
+void headless_packet_stream_end(HeadlessPacketStream *stream);
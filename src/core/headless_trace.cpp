@@ -0,0 +1,265 @@
+#include "headless_trace.h"
+#include <math.h>
+#include <string.h>
+#include <inttypes.h>
+#include "log.h"
+#include "game/team.h"
+#include "common/game_constants.h"
+#include "../server_constants.h"
+
+#define HEADLESS_TRACE_MAGIC "pot-headless-trace"
+#define HEADLESS_TRACE_VERSION 3
+
+// トレースの結果を左右する設定（照合時に一致を確認する）
+static void format_header(char *buffer, size_t size, const ServerConfig *config, int match_count)
+{
+    const ScoreFormat *format = &config->score_format;
+    snprintf(buffer, size, "%s v%d matches=%d sim_hz=%d doubles=%d court=%s sets=%d games=%d no_ad=%d tiebreak=%d match_tiebreak=%d",
+             HEADLESS_TRACE_MAGIC, HEADLESS_TRACE_VERSION, match_count, config->simulation_hz, config->doubles ? 1 : 0,
+             court_physics(config->court_surface)->name,
+             format->sets_to_win, format->games_per_set, format->no_ad ? 1 : 0, format->tiebreak ? 1 : 0,
+             format->match_tiebreak ? 1 : 0);
+}
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size);
+
+// 記録したビルドの識別値（libs/common の物理定数）
+// このリポジトリの外で決まり、変わると同じ処理でも結果が変わるもの
+static uint64_t build_fingerprint()
+{
+    static const float COMMON_CONSTANTS[] = {
+        GameConstants::FRAME_TIME, GameConstants::GRAVITY, GameConstants::BOUNCE_RESTITUTION,
+        GameConstants::GROUND_Y, GameConstants::NET_HEIGHT, GameConstants::NET_POSITION_Z,
+        GameConstants::COURT_HALF_WIDTH, GameConstants::COURT_HALF_LENGTH, GameConstants::COURT_MAX_HEIGHT,
+        GameConstants::PLAYER_BASELINE_DISTANCE, GameConstants::BALL_SERVE_HEIGHT,
+        GameConstants::BALL_SERVE_OFFSET_FROM_BASELINE, GameConstants::PLAYER_MOVE_SPEED,
+        GameConstants::PLAYER_MOVEMENT_EPSILON,
+    };
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = hash_bytes(hash, COMMON_CONSTANTS, sizeof(COMMON_CONSTANTS));
+    return hash;
+}
+
+HeadlessTraceOpenResult headless_trace_open(HeadlessTrace *trace, HeadlessTraceMode mode, const char *path,
+                                            const ServerConfig *config, int match_count)
+{
+    memset(trace, 0, sizeof(HeadlessTrace));
+    trace->mode = mode;
+    if (mode == HEADLESS_TRACE_OFF)
+        return HEADLESS_TRACE_OPENED;
+
+    trace->file = fopen(path, (mode == HEADLESS_TRACE_RECORD) ? "w" : "r");
+    if (!trace->file)
+    {
+        LOG_ERROR("トレースファイルを開けません: " << path);
+        return HEADLESS_TRACE_FAILED;
+    }
+
+    char expected[256];
+    format_header(expected, sizeof(expected), config, match_count);
+    char build[32];
+    snprintf(build, sizeof(build), "build=%016" PRIx64, build_fingerprint());
+
+    if (mode == HEADLESS_TRACE_RECORD)
+    {
+        fprintf(trace->file, "%s %s\n", expected, build);
+        return HEADLESS_TRACE_OPENED;
+    }
+
+    // ヘッダーは「設定 build=識別値」
+    char header[256];
+    if (!fgets(header, sizeof(header), trace->file))
+        header[0] = '\0';
+    header[strcspn(header, "\n")] = '\0';
+    char *recorded_build = strstr(header, " build=");
+    if (recorded_build)
+        *recorded_build++ = '\0';
+
+    HeadlessTraceOpenResult result = HEADLESS_TRACE_OPENED;
+    if (strcmp(header, expected) != 0)
+    {
+        LOG_ERROR("トレースの設定が一致しません\n  記録: " << header << "\n  実行: " << expected);
+        result = HEADLESS_TRACE_FAILED;
+    }
+    else if (!recorded_build || strcmp(recorded_build, build) != 0)
+    {
+        LOG_REPORT("トレースは別のビルドで記録されたため照合しません（記録: " << (recorded_build ? recorded_build : "なし")
+                   << "、実行: " << build << "）。このビルドで記録し直すと照合できます");
+        result = HEADLESS_TRACE_OTHER_BUILD;
+    }
+
+    if (result != HEADLESS_TRACE_OPENED)
+    {
+        fclose(trace->file);
+        trace->file = nullptr;
+    }
+    return result;
+}
+
+bool headless_trace_tick(HeadlessTrace *trace, int match, int tick, const GameState *state)
+{
+    if (trace->mode == HEADLESS_TRACE_OFF || trace->diverged)
+        return !trace->diverged;
+
+    uint64_t hash = game_state_hash(state);
+    trace->ticks_checked++;
+
+    if (trace->mode == HEADLESS_TRACE_RECORD)
+    {
+        fprintf(trace->file, "%d %d %016" PRIx64 "\n", match, tick, hash);
+        return true;
+    }
+
+    int recorded_match = -1;
+    int recorded_tick = -1;
+    uint64_t recorded_hash = 0;
+    if (fscanf(trace->file, "%d %d %" SCNx64, &recorded_match, &recorded_tick, &recorded_hash) != 3 ||
+        recorded_match != match || recorded_tick != tick || recorded_hash != hash)
+    {
+        const Ball *ball = &state->balls[PRIMARY_BALL];
+        LOG_ERROR("トレース不一致: 試合 " << match << " tick " << tick
+                  << " (記録: 試合 " << recorded_match << " tick " << recorded_tick << ")"
+                  << "\n  フェーズ " << (int)state->phase << ", ボール (" << ball->point.x << ", " << ball->point.y
+                  << ", " << ball->point.z << "), バウンド " << ball->bounce_count << ", 打数 " << ball->hit_count
+                  << ", スコア " << state->score.view.point_p1 << "-" << state->score.view.point_p2
+                  << " ゲーム " << state->score.games[0] << "-" << state->score.games[1]
+                  << " セット " << state->score.sets[0] << "-" << state->score.sets[1]);
+        trace->diverged = true;
+        return false;
+    }
+    return true;
+}
+
+bool headless_trace_close(HeadlessTrace *trace)
+{
+    if (!trace->file)
+        return !trace->diverged;
+
+    bool ok = !trace->diverged;
+    if (ok && trace->mode == HEADLESS_TRACE_VERIFY)
+    {
+        // 記録側の方が長い（試合が早く終わった）のも不一致
+        int match, tick;
+        uint64_t hash;
+        if (fscanf(trace->file, "%d %d %" SCNx64, &match, &tick, &hash) == 3)
+        {
+            LOG_ERROR("トレース不一致: 記録は試合 " << match << " tick " << tick << " まで続いている");
+            ok = false;
+        }
+    }
+
+    fclose(trace->file);
+    trace->file = nullptr;
+    return ok;
+}
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// 構造体の詰め物を含めないよう、フィールドを1つずつ混ぜる
+#define HASH_FIELD(hash, field) hash = hash_bytes(hash, &(field), sizeof(field))
+
+uint64_t game_state_hash(const GameState *state)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    int phase = (int)state->phase;
+    HASH_FIELD(hash, phase);
+    HASH_FIELD(hash, state->state_timer);
+    HASH_FIELD(hash, state->server_player_id);
+    HASH_FIELD(hash, state->match_winner);
+
+    HASH_FIELD(hash, state->ball_count);
+    for (int i = 0; i < state->ball_count && i < MAX_BALLS; i++)
+    {
+        const Ball *ball = &state->balls[i];
+        HASH_FIELD(hash, ball->point.x);
+        HASH_FIELD(hash, ball->point.y);
+        HASH_FIELD(hash, ball->point.z);
+        HASH_FIELD(hash, ball->velocity.x);
+        HASH_FIELD(hash, ball->velocity.y);
+        HASH_FIELD(hash, ball->velocity.z);
+        HASH_FIELD(hash, ball->last_hit_player_id);
+        HASH_FIELD(hash, ball->bounce_count);
+        HASH_FIELD(hash, ball->hit_count);
+        HASH_FIELD(hash, ball->gravity_multiplier);
+        HASH_FIELD(hash, state->ball_roles[i].owner_id);
+    }
+
+    for (int i = 0; i < state->player_count && i < MAX_CLIENTS; i++)
+    {
+        const Player *player = &state->players[i];
+        HASH_FIELD(hash, player->point.x);
+        HASH_FIELD(hash, player->point.y);
+        HASH_FIELD(hash, player->point.z);
+    }
+
+    const MatchScore *score = &state->score;
+    HASH_FIELD(hash, score->point_state);
+    HASH_FIELD(hash, score->sets);
+    HASH_FIELD(hash, score->games);
+    HASH_FIELD(hash, score->tiebreak_points);
+    HASH_FIELD(hash, score->tiebreak_target);
+    HASH_FIELD(hash, state->ability_engine.count);
+    return hash;
+}
+
+static bool point_finite(const Point3d *point)
+{
+    return isfinite(point->x) && isfinite(point->y) && isfinite(point->z);
+}
+
+const char *game_state_check_invariants(const GameState *state)
+{
+    if (state->ball_count < 1 || state->ball_count > MAX_BALLS)
+        return "ボール数が範囲外";
+
+    for (int i = 0; i < state->ball_count; i++)
+    {
+        const Ball *ball = &state->balls[i];
+        if (!point_finite(&ball->point) || !point_finite(&ball->velocity))
+            return "ボールの位置・速度が有限でない";
+        if (ball->bounce_count < 0 || ball->hit_count < 0)
+            return "バウンド数・打数が負";
+        if (!(ball->gravity_multiplier > 0.0f))
+            return "ボールの重力倍率が正でない";
+        if (ball->last_hit_player_id < 0 || ball->last_hit_player_id >= state->player_count)
+            return "最後に打ったプレイヤーが範囲外";
+    }
+
+    const float side_limit = GameConstants::COURT_HALF_WIDTH + PLAYER_AREA_SIDE_MARGIN;
+    const float back_limit = GameConstants::COURT_HALF_LENGTH + PLAYER_AREA_BACK_MARGIN;
+    for (int i = 0; i < state->player_count; i++)
+    {
+        const Point3d *point = &state->players[i].point;
+        if (!point_finite(point))
+            return "プレイヤーの位置が有限でない";
+        float depth = point->z * team_side(team_of(i));
+        if (fabsf(point->x) > side_limit || depth < GameConstants::NET_POSITION_Z || depth > back_limit)
+            return "プレイヤーが移動範囲の外";
+    }
+
+    const MatchScore *score = &state->score;
+    for (int team = 0; team < 2; team++)
+    {
+        if (score->sets[team] < 0 || score->sets[team] > score->format.sets_to_win)
+            return "セット数が範囲外";
+        if (score->games[team] < 0 || score->games[team] > score->format.games_per_set + 1)
+            return "ゲーム数が範囲外";
+    }
+    if (score->sets[0] >= score->format.sets_to_win && score->sets[1] >= score->format.sets_to_win)
+        return "両チームが勝利条件を満たしている";
+    if (score->tiebreak_target == 0 && score->view.point_p1 > TENNIS_SCORE_ADVANTAGE)
+        return "ポイント表示が範囲外";
+    if (state->server_player_id < 0 || state->server_player_id >= state->player_count)
+        return "サーバーが範囲外";
+    return nullptr;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "server_config.h"
+#include "game/game_state.h"
+
+// ヘッドレス実行の状態ハッシュ列（ゴールデントレース）の記録・照合
+// 物理・得点処理を変更したときに、変更前に記録したトレースと毎tick突き合わせて差分を検出する
+// ハッシュは浮動小数点のビット列をそのまま使うので、同じコンパイラ・最適化設定同士でのみ比較できる
+
+enum HeadlessTraceMode
+{
+    HEADLESS_TRACE_OFF,
+    HEADLESS_TRACE_RECORD,
+    HEADLESS_TRACE_VERIFY,
+};
+
+struct HeadlessTrace
+{
+    HeadlessTraceMode mode;
+    FILE *file;
+    long long ticks_checked;
+    bool diverged;
+};
+
+enum HeadlessTraceOpenResult
+{
+    HEADLESS_TRACE_OPENED,
+    HEADLESS_TRACE_FAILED,       // 開けない・設定が一致しない
+    HEADLESS_TRACE_OTHER_BUILD,  // 設定は同じだが、libs/common の定数が違うビルドで記録された
+};
+
+// トレースファイルを開く（照合時はヘッダーの設定とビルドの識別値を確かめる）
+HeadlessTraceOpenResult headless_trace_open(HeadlessTrace *trace, HeadlessTraceMode mode, const char *path,
+                                            const ServerConfig *config, int match_count);
+
+// 1tick分を記録・照合する（照合で食い違ったらfalse、以降は照合しない）
+bool headless_trace_tick(HeadlessTrace *trace, int match, int tick, const GameState *state);
+
+// 閉じる（照合時は記録側のtick数と一致したか）
+bool headless_trace_close(HeadlessTrace *trace);
+
+// 得点・物理に関わる状態のハッシュ（FNV-1a）
+uint64_t game_state_hash(const GameState *state);
+
+// 状態が壊れていないかの検査（問題なければnullptr、あれば内容）
+const char *game_state_check_invariants(const GameState *state);
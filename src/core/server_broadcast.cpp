@@ -3,10 +3,158 @@
 #include "common/ability.h"
 #include "log.h"
 
+// 現在のtickと各プレイヤーの入力確認番号をパケット末尾に書く
+static void stamp_packet(const ServerContext *ctx, Packet *packet)
+{
+    StateStamp stamp;
+    stamp.server_tick = ctx->server_tick;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+        stamp.input_ack[i] = ctx->connections[i].last_input_sequence;
+    network_stamp_state(packet, &stamp);
+}
+
+void broadcast_packet(ServerContext *ctx, const Packet *packet)
+{
+    Packet stamped = *packet;
+    stamp_packet(ctx, &stamped);
+    network_broadcast(ctx->players, ctx->connections, &stamped);
+    spectator_publish(&ctx->spectators, &stamped);
+}
+
+// スナップショットを今回の送信対象のクライアントへだけ送る（送れなければ捨てる）
+static void broadcast_snapshot_packet(ServerContext *ctx, const Packet *packet)
+{
+    Packet stamped = *packet;
+    stamp_packet(ctx, &stamped);
+
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        ClientConnection *connection = &ctx->connections[i];
+        if (!ctx->players[i].connected || !connection->socket || !connection->snapshot_pacer.due)
+            continue;
+
+        NetworkTrySendResult result = network_try_send_packet(connection, &stamped);
+        if (result == NETWORK_SEND_PARTIAL || result == NETWORK_SEND_SKIPPED)
+            snapshot_pacer_on_partial_send(&connection->snapshot_pacer);
+    }
+    spectator_publish(&ctx->spectators, &stamped);
+}
+
+void broadcast_begin_snapshot(ServerContext *ctx)
+{
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        ClientConnection *connection = &ctx->connections[i];
+        if (!ctx->players[i].connected || !connection->socket)
+            continue;
+
+        int queued = network_send_queue_bytes(connection->socket);
+        snapshot_pacer_begin_round(&connection->snapshot_pacer, queued, connection->send_tail_length > 0);
+    }
+}
+
+// 1クライアントへスタンプつきで送る
+static void send_stamped(ServerContext *ctx, TCPsocket socket, Packet *packet)
+{
+    stamp_packet(ctx, packet);
+    network_send_packet(socket, packet);
+}
+
+// 分身をまとめて1パケットにする
+static Packet create_extra_balls_packet(const ServerContext *ctx)
+{
+    int owner_ids[MAX_BALLS];
+    int extra_count = ctx->state.ball_count - 1;
+    for (int i = 0; i < extra_count; i++)
+        owner_ids[i] = ctx->state.ball_roles[i + 1].owner_id;
+    return create_packet_extra_balls(&ctx->state.balls[1], owner_ids, extra_count);
+}
+
+// ゲーム数・タイブレークを含むスコア
+static Packet create_score_detail_packet(const MatchScore *score, uint32_t events)
+{
+    ScoreDetailState detail;
+    memset(&detail, 0, sizeof(detail));
+    for (int team = 0; team < 2; team++)
+    {
+        detail.games[team] = score->games[team];
+        detail.sets[team] = score->sets[team];
+        detail.tiebreak_points[team] = score->tiebreak_points[team];
+    }
+    detail.tiebreak_target = score->tiebreak_target;
+    detail.sets_to_win = score->format.sets_to_win;
+    detail.events = events;
+    return create_packet_score_detail(&detail);
+}
+
+void send_full_snapshot(ServerContext *ctx, TCPsocket socket)
+{
+    Packet phase_packet = create_packet_phase(ctx->state.phase);
+    send_stamped(ctx, socket, &phase_packet);
+
+    Packet score_packet = create_packet_score(&ctx->state.score.view);
+    send_stamped(ctx, socket, &score_packet);
+
+    Packet detail_packet = create_score_detail_packet(&ctx->state.score, SCORE_EVENT_RESET);
+    send_stamped(ctx, socket, &detail_packet);
+
+    // 試合に参加していないスロットは送らない（シングルスのクライアントは2人分しか扱わない）
+    for (int i = 0; i < ctx->state.player_count; i++)
+    {
+        Packet player_packet = create_packet_player_state(&ctx->state.players[i]);
+        send_stamped(ctx, socket, &player_packet);
+
+        Packet ability_packet = create_packet_ability_state(&ctx->state.ability_states[i]);
+        send_stamped(ctx, socket, &ability_packet);
+    }
+
+    Packet ball_packet = create_packet_ball_state(&ctx->state.balls[PRIMARY_BALL]);
+    send_stamped(ctx, socket, &ball_packet);
+
+    if (ctx->state.ball_count > 1)
+    {
+        Packet extra_packet = create_extra_balls_packet(ctx);
+        send_stamped(ctx, socket, &extra_packet);
+    }
+}
+
 void broadcast_ball_state(ServerContext *ctx)
 {
-    Packet ball_packet = create_packet_ball_state(&ctx->state.ball);
-    network_broadcast(ctx->players, ctx->connections, &ball_packet);
+    Packet ball_packet = create_packet_ball_state(&ctx->state.balls[PRIMARY_BALL]);
+    broadcast_snapshot_packet(ctx, &ball_packet);
+
+    // 分身は何個あっても1パケット、消えたときは空の一覧を1回だけ（間引かずに）送る
+    int extra_count = ctx->state.ball_count - 1;
+    if (extra_count > 0)
+    {
+        Packet extra_packet = create_extra_balls_packet(ctx);
+        broadcast_snapshot_packet(ctx, &extra_packet);
+    }
+    else if (ctx->last_sent_extra_ball_count > 0)
+    {
+        Packet extra_packet = create_extra_balls_packet(ctx);
+        broadcast_packet(ctx, &extra_packet);
+    }
+    ctx->last_sent_extra_ball_count = extra_count;
+}
+
+void broadcast_player_states(ServerContext *ctx, int idle_interval_ticks)
+{
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (!ctx->players[i].connected)
+            continue;
+
+        bool idle_due = ++ctx->player_state_idle_ticks[i] >= idle_interval_ticks;
+        if (!ctx->player_state_dirty[i] && !idle_due)
+            continue;
+
+        Packet player_packet = create_packet_player_state(&ctx->state.players[i]);
+        broadcast_snapshot_packet(ctx, &player_packet);
+
+        ctx->player_state_dirty[i] = false;
+        ctx->player_state_idle_ticks[i] = 0;
+    }
 }
 
 void broadcast_phase_update(ServerContext *ctx)
@@ -14,7 +162,7 @@ void broadcast_phase_update(ServerContext *ctx)
     if (ctx->state.phase != ctx->last_sent_phase)
     {
         Packet phase_packet = create_packet_phase(ctx->state.phase);
-        network_broadcast(ctx->players, ctx->connections, &phase_packet);
+        broadcast_packet(ctx, &phase_packet);
 
         ctx->last_sent_phase = ctx->state.phase;
     }
@@ -22,13 +170,17 @@ void broadcast_phase_update(ServerContext *ctx)
 
 void broadcast_score_update(ServerContext *ctx)
 {
-    if (memcmp(&ctx->state.score, &ctx->last_sent_score, sizeof(GameScore)) != 0)
-    {
-        Packet score_packet = create_packet_score(&ctx->state.score);
-        network_broadcast(ctx->players, ctx->connections, &score_packet);
+    MatchScore *score = &ctx->state.score;
+    if (score->pending_events == 0)
+        return;
 
-        ctx->last_sent_score = ctx->state.score;
-    }
+    Packet score_packet = create_packet_score(&score->view);
+    broadcast_packet(ctx, &score_packet);
+
+    Packet detail_packet = create_score_detail_packet(score, score->pending_events);
+    broadcast_packet(ctx, &detail_packet);
+
+    score->pending_events = 0;
 }
 
 void broadcast_initial_player_states(ServerContext *ctx)
@@ -38,7 +190,7 @@ void broadcast_initial_player_states(ServerContext *ctx)
         if (ctx->players[i].connected && ctx->connections[i].socket)
         {
             Packet player_packet = create_packet_player_state(&ctx->state.players[i]);
-            network_broadcast(ctx->players, ctx->connections, &player_packet);
+            broadcast_packet(ctx, &player_packet);
         }
     }
 }
@@ -51,12 +203,12 @@ void broadcast_ability_state(ServerContext *ctx, int player_id)
     }
 
     Packet ability_packet = create_packet_ability_state(&ctx->state.ability_states[player_id]);
-    network_broadcast(ctx->players, ctx->connections, &ability_packet);
+    broadcast_packet(ctx, &ability_packet);
 }
 
 void broadcast_match_result(ServerContext *ctx, int winner_id)
 {
-    LOG_SUCCESS("試合結果を送信: 勝者 Player " << (winner_id + 1));
+    LOG_SUCCESS("試合結果を送信: 勝者 " << (ctx->state.player_count > TEAM_COUNT ? "Team " : "Player ") << (winner_id + 1));
     Packet result_packet = create_packet_match_result(winner_id);
-    network_broadcast(ctx->players, ctx->connections, &result_packet);
+    broadcast_packet(ctx, &result_packet);
 }
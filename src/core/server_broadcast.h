@@ -2,13 +2,29 @@
 
 #include "server_context.h"
 
-// ボール状態をブロードキャスト
+// パケットを全プレイヤーへ送信し、観戦者向けにも記録する
+// 送信するパケットには末尾に StateStamp（tick・入力確認番号）を付ける
+void broadcast_packet(ServerContext *ctx, const Packet *packet);
+
+// 現在の状態一式を1クライアントへ送信（途中参加時の同期用、StateStamp つき）
+void send_full_snapshot(ServerContext *ctx, TCPsocket socket);
+
+// スナップショット送信の最初に呼び、クライアントごとに今回送るかを決める
+// 送信キューが詰まっているクライアントは間隔を広げ、古いスナップショットを積まずに捨てる
+void broadcast_begin_snapshot(ServerContext *ctx);
+
+// ボール状態をブロードキャスト（スナップショット、broadcast_begin_snapshot の後に呼ぶ）
+// 本球は BALL_STATE、分身はまとめて EXTRA_BALLS の1パケットで送る
 void broadcast_ball_state(ServerContext *ctx);
 
+// プレイヤー状態をブロードキャスト（スナップショット、broadcast_begin_snapshot の後に呼ぶ）
+// 移動したプレイヤーは1tickに1回、静止中は interval_ticks ごとに送信
+void broadcast_player_states(ServerContext *ctx, int idle_interval_ticks);
+
 // ゲームフェーズをブロードキャスト（変更時のみ）
 void broadcast_phase_update(ServerContext *ctx);
 
-// スコアをブロードキャスト（変更時のみ）
+// スコアをブロードキャスト（未送信のスコアイベントがあるときのみ）
 void broadcast_score_update(ServerContext *ctx);
 
 // 初期プレイヤー状態をブロードキャスト
@@ -0,0 +1,217 @@
+#include "server_config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "log.h"
+#include "common/game_constants.h"
+#include "network/network.h"
+#include "../server_constants.h"
+
+void server_config_set_defaults(ServerConfig *config)
+{
+    const int frame_hz = (int)(1.0f / GameConstants::FRAME_TIME + 0.5f);
+
+    config->port = 5000;
+    config->spectator_port = -1;
+    config->simulation_hz = frame_hz;
+    config->snapshot_hz = frame_hz;
+    config->spectator_snapshot_hz = DEFAULT_SPECTATOR_SNAPSHOT_HZ;
+    config->player_idle_broadcast_hz = DEFAULT_PLAYER_IDLE_BROADCAST_HZ;
+    config->doubles = false;
+    config->score_format = SCORE_FORMAT_SHORT;
+    config->no_ad = false;
+    config->match_tiebreak = false;
+    config->court_surface = COURT_SURFACE_HARD;
+    config->ai_players = 0;
+    config->workers = 1;
+    config->checkpoint_path[0] = '\0';
+    config->checkpoint_hz = DEFAULT_CHECKPOINT_HZ;
+    config->admin_socket_path[0] = '\0';
+    config->debug_log = false;
+}
+
+// 整数値を読む（数字以外が混ざっていれば false）
+static bool parse_int(const char *value, int *out)
+{
+    char *end = nullptr;
+    long number = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || number < INT_MIN || number > INT_MAX)
+        return false;
+    *out = (int)number;
+    return true;
+}
+
+static bool parse_bool(const char *value, bool *out)
+{
+    if (strcmp(value, "true") == 0 || strcmp(value, "1") == 0)
+        *out = true;
+    else if (strcmp(value, "false") == 0 || strcmp(value, "0") == 0)
+        *out = false;
+    else
+        return false;
+    return true;
+}
+
+bool server_config_set_value(ServerConfig *config, const char *key, const char *value)
+{
+    if (strcmp(key, "port") == 0)
+        return parse_int(value, &config->port);
+    else if (strcmp(key, "spectator_port") == 0)
+        return parse_int(value, &config->spectator_port);
+    else if (strcmp(key, "simulation_hz") == 0)
+        return parse_int(value, &config->simulation_hz);
+    else if (strcmp(key, "snapshot_hz") == 0)
+        return parse_int(value, &config->snapshot_hz);
+    else if (strcmp(key, "spectator_snapshot_hz") == 0)
+        return parse_int(value, &config->spectator_snapshot_hz);
+    else if (strcmp(key, "player_idle_broadcast_hz") == 0)
+        return parse_int(value, &config->player_idle_broadcast_hz);
+    else if (strcmp(key, "mode") == 0)
+    {
+        if (strcmp(value, "doubles") == 0)
+            config->doubles = true;
+        else if (strcmp(value, "singles") == 0)
+            config->doubles = false;
+        else
+            return false;
+    }
+    else if (strcmp(key, "score_format") == 0)
+        return score_format_from_name(value, &config->score_format);
+    else if (strcmp(key, "court") == 0)
+        return court_surface_from_name(value, &config->court_surface);
+    else if (strcmp(key, "no_ad") == 0)
+        return parse_bool(value, &config->no_ad);
+    else if (strcmp(key, "match_tiebreak") == 0)
+        return parse_bool(value, &config->match_tiebreak);
+    else if (strcmp(key, "ai_players") == 0)
+        return parse_int(value, &config->ai_players);
+    else if (strcmp(key, "checkpoint_path") == 0)
+        snprintf(config->checkpoint_path, sizeof(config->checkpoint_path), "%s", value);
+    else if (strcmp(key, "checkpoint_hz") == 0)
+        return parse_int(value, &config->checkpoint_hz);
+    else if (strcmp(key, "admin_socket_path") == 0)
+        snprintf(config->admin_socket_path, sizeof(config->admin_socket_path), "%s", value);
+    else if (strcmp(key, "workers") == 0)
+        return parse_int(value, &config->workers);
+    else if (strcmp(key, "debug_log") == 0)
+        return parse_bool(value, &config->debug_log);
+    else
+        return false;
+    return true;
+}
+
+// 前後の空白を取り除く（文字列を直接書き換える）
+static char *trim(char *str)
+{
+    while (isspace((unsigned char)*str))
+        str++;
+
+    char *end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1]))
+        end--;
+    *end = '\0';
+    return str;
+}
+
+bool server_config_load_file(ServerConfig *config, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        LOG_ERROR("設定ファイルを開けません: " << path);
+        return false;
+    }
+
+    bool ok = true;
+    char line[256];
+    int line_number = 0;
+
+    while (fgets(line, sizeof(line), file))
+    {
+        line_number++;
+
+        char *comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        char *text = trim(line);
+        if (*text == '\0')
+            continue;
+
+        char *separator = strchr(text, '=');
+        if (!separator)
+        {
+            LOG_ERROR("設定ファイルの書式エラー: " << path << ":" << line_number);
+            ok = false;
+            continue;
+        }
+
+        *separator = '\0';
+        char *key = trim(text);
+        char *value = trim(separator + 1);
+
+        if (!server_config_set_value(config, key, value))
+        {
+            LOG_ERROR("不明な設定項目か不正な値: " << key << " = " << value << " (" << path << ":" << line_number << ")");
+            ok = false;
+        }
+    }
+
+    fclose(file);
+    return ok;
+}
+
+static int clamp_hz(int hz, int max_hz)
+{
+    if (hz < 1) return 1;
+    if (hz > max_hz) return max_hz;
+    return hz;
+}
+
+void server_config_finalize(ServerConfig *config)
+{
+    if (config->spectator_port < 0)
+        config->spectator_port = config->port + 1;
+
+    // 送信レートはシミュレーションレートを超えられない
+    config->simulation_hz = clamp_hz(config->simulation_hz, MAX_SIMULATION_HZ);
+    config->snapshot_hz = clamp_hz(config->snapshot_hz, config->simulation_hz);
+    config->spectator_snapshot_hz = clamp_hz(config->spectator_snapshot_hz, config->simulation_hz);
+    // 静止中の送信はスナップショット送信の回数で数えるので、スナップショットより速くはできない
+    config->player_idle_broadcast_hz = clamp_hz(config->player_idle_broadcast_hz, config->snapshot_hz);
+    config->checkpoint_hz = clamp_hz(config->checkpoint_hz, config->simulation_hz);
+
+    if (config->ai_players < 0) config->ai_players = 0;
+    if (config->ai_players > server_config_match_players(config))
+        config->ai_players = server_config_match_players(config);
+
+    if (config->workers < 1) config->workers = 1;
+    if (config->workers > MAX_WORKERS) config->workers = MAX_WORKERS;
+
+    if (config->no_ad) config->score_format.no_ad = true;
+    if (config->match_tiebreak) config->score_format.match_tiebreak = true;
+}
+
+int server_config_match_players(const ServerConfig *config)
+{
+    return config->doubles ? MAX_CLIENTS : REQUIRED_CLIENTS;
+}
+
+// base_hz で回る処理を何回に1回行えば hz になるか（四捨五入、最低1）
+static int interval_for(int base_hz, int hz)
+{
+    int count = (base_hz + hz / 2) / hz;
+    return (count < 1) ? 1 : count;
+}
+
+int server_config_ticks_per(const ServerConfig *config, int hz)
+{
+    return interval_for(config->simulation_hz, hz);
+}
+
+int server_config_idle_broadcast_interval(const ServerConfig *config)
+{
+    return interval_for(config->snapshot_hz, config->player_idle_broadcast_hz);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "game/score_logic.h"
+#include "physics/court_physics.h"
+
+// サーバーの実行時設定
+// デフォルト値 → 設定ファイル → コマンドライン引数 の順に上書きする
+struct ServerConfig
+{
+    // ネットワーク
+    int port;
+    int spectator_port;            // -1: port + 1、0: 無効
+
+    // 更新レート（Hz）
+    int simulation_hz;             // 物理・フェーズ更新
+    int snapshot_hz;               // プレイヤーへのスナップショット送信
+    int spectator_snapshot_hz;     // 観戦者へのスナップショット送信
+    int player_idle_broadcast_hz;  // 静止中プレイヤーの状態送信
+
+    // ダブルス（2対2）で試合を行う
+    bool doubles;
+
+    // 試合形式（score_format で形式を選び、no_ad / match_tiebreak を上乗せする）
+    ScoreFormat score_format;
+    bool no_ad;
+    bool match_tiebreak;
+
+    // コート面（バウンドの跳ね方）
+    CourtSurface court_surface;
+
+    // サーバー側で操作するプレイヤーの人数（0〜1試合の人数）
+    int ai_players;
+
+    // 試合状態のチェックポイント（空文字列: 無効）
+    char checkpoint_path[256];
+    int checkpoint_hz;
+
+    // 管理ソケットのパス（空文字列: 無効）
+    char admin_socket_path[108];
+
+    // ワーカープロセス数（1: 単一プロセス、2以上: 受付プロセスが接続を各ワーカーへ振り分ける）
+    int workers;
+
+    bool debug_log;
+};
+
+// デフォルト値を設定
+void server_config_set_defaults(ServerConfig *config);
+
+// 設定ファイル（1行1項目の "key = value" 形式、# 以降はコメント）を読み込む
+// 戻り値: 成功時true、ファイルが開けない・不正な行がある場合false
+bool server_config_load_file(ServerConfig *config, const char *path);
+
+// 1項目を設定する（コマンドライン引数と設定ファイルで共通）
+// 戻り値: 既知のキーで値が正しければtrue
+bool server_config_set_value(ServerConfig *config, const char *key, const char *value);
+
+// 値の範囲を補正し、未指定の項目を確定する
+// （レートは1以上に丸め、送信レートはシミュレーションレート、静止中の送信レートはスナップショットレートを上限にする）
+void server_config_finalize(ServerConfig *config);
+
+// 1試合の人数（シングルス2、ダブルス4）
+int server_config_match_players(const ServerConfig *config);
+
+// 指定レートで送信するときのシミュレーションtick間隔
+int server_config_ticks_per(const ServerConfig *config, int hz);
+
+// 静止中プレイヤーの状態を何回のスナップショット送信に1回送るか
+int server_config_idle_broadcast_interval(const ServerConfig *config);
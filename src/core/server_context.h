@@ -2,28 +2,107 @@
 
 #include <SDL2/SDL_net.h>
 #include "game/game_state.h"
+#include "game/match_stats.h"
 #include "network/network.h"
+#include "network/spectator.h"
+#include "network/matchmaking.h"
+#include "player/ai_player.h"
+#include "server_config.h"
+#include "event_loop.h"
+#include "checkpoint.h"
+#include "admin_server.h"
+#include "worker_pool.h"
+#include "../server_constants.h"
 
 // サーバー全体のコンテキスト構造体
 // グローバル変数を集約し、関数間でのデータ受け渡しを明確化
 struct ServerContext
 {
+    // 実行時設定
+    ServerConfig config;
+
     // ゲーム状態
     GameState state;
+    const CourtPhysics *court;  // 試合のコート面の物理処理（試合開始時に state.surface から選ぶ）
 
     // プレイヤー管理
     Player players[MAX_CLIENTS];
     ClientConnection connections[MAX_CLIENTS];
 
+    // サーバー側で操作するプレイヤー（ソケットを持たずにスロットを埋める）
+    AiPlayer ai_players[MAX_CLIENTS];
+
+    // 能力の持続時間を進めるための端数（ゲームフレーム未満の経過時間）
+    float ability_frame_time;
+
+    // シミュレーションtick数（状態パケットのスタンプ、一時停止中は進まない）
+    uint32_t server_tick;
+
+    // 試合の空きを待つ接続（レーティング帯で索引付け）
+    MatchmakingQueue matchmaking;
+
+    // 再接続要求待ちのソケット（猶予期間中のスロットへ戻る前の状態）
+    TCPsocket pending_sockets[MAX_PENDING_RESUMES];
+    Uint32 pending_since_ms[MAX_PENDING_RESUMES];
+
     // ネットワーク
-    TCPsocket server_socket;
-    SDLNet_SocketSet socket_set;
+    TCPsocket server_socket;  // ワーカーではNULL（リスナーは受付プロセスが持つ）
+    TCPsocket worker_inbox;   // ワーカー: 受付プロセスが振り分けた接続が届く（単一プロセスではNULL）
+    EventLoop loop;
+
+    // クラッシュ復旧用の試合状態（ファイルを共有マッピング）
+    CheckpointStore checkpoint;
+    bool resumed_match;  // チェックポイントから再開した試合（開始処理を省く）
+
+    // 観戦者（プレイヤーとは別リスナー）
+    SpectatorHub spectators;
+
+    // 接続受付のレート制限
+    RateLimiter accept_limiter;
+    RateLimiter spectator_accept_limiter;
+    uint32_t rejected_accepts;           // 受付レート超過で閉じた接続（累計、観戦者を含む）
+    uint32_t reported_rejected_accepts;  // 前回ログ出力時点の rejected_accepts
 
-    // フェーズ・スコア変更検知用
+    // 受信制限ログ・接続品質ログの前回出力時刻
+    Uint32 last_throttle_report_ms;
+    Uint32 last_link_report_ms;
+
+    // プレイヤー状態の送信管理（1tickに1回まで）
+    bool player_state_dirty[MAX_CLIENTS];
+    int player_state_idle_ticks[MAX_CLIENTS];
+
+    // 試合イベントから集計した統計（試合開始で0に戻る）
+    MatchStats match_stats;
+
+    // フェーズ変更検知用（スコアは MatchScore.pending_events で検知する）
     GamePhase last_sent_phase;
-    GameScore last_sent_score;
+    int last_sent_extra_ball_count;
 
     // 実行制御（シグナルハンドラーから参照）
     volatile int *running;
+    volatile int *drain_requested;    // 新規受付を止めて現在の試合だけ続ける
+    volatile int *restart_requested;  // 新プロセスへリスナーを渡してからドレインする
+
+    // ドレイン中（新しい接続・試合を受け付けない）
+    bool draining;
+
+    // ホットリスタートで新プロセスに渡す起動引数
+    char **argv;
+
+    // ホットリスタート後の再接続の受け渡し（リスナーは新プロセスが持つため、旧プロセスの試合への再接続も新プロセスに届く）
+    TCPsocket resume_inbox;    // 旧プロセス側: 新プロセスから転送された再接続を受け取る
+    TCPsocket resume_forward;  // 新プロセス側: 自分の試合にない再接続を旧プロセスへ渡す
+
+    // ホットリスタートで起動した新プロセス（旧プロセス側）
+    pid_t successor_pid;                 // 0: なし・終了を確認済み
+    TCPsocket successor_ready;           // 準備完了の通知を待つ経路（NULL: 待っていない）
+    TCPsocket successor_resume_inbox;    // 準備完了で resume_inbox に切り替える
+    uint64_t successor_ready_deadline;   // これまでに通知がなければ新プロセスを止めて受付を続ける
+
+    // 管理ソケット（admin_socket_path が空なら起動しない）
+    AdminServer admin;
+
+    // ワーカーモードで受付プロセスと共有する自分の状態（単一プロセスではNULL）
+    WorkerStatus *worker_status;
 };
 
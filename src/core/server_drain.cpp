@@ -0,0 +1,377 @@
+#include "server_drain.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "log.h"
+#include "server_matchmaking.h"
+
+// ワーカー: 受付プロセスの振り分けに使う待機人数と、再接続を受けるセッションを公開する
+static void server_publish_worker_status(ServerContext *ctx)
+{
+    if (!ctx->worker_status)
+        return;
+
+    uint64_t tokens[MAX_CLIENTS];
+    for (int i = 0; i < MAX_CLIENTS; i++)
+        tokens[i] = ctx->connections[i].session_token;
+    worker_status_publish(ctx->worker_status, ctx->matchmaking.count, tokens);
+}
+
+static void server_poll_successor(ServerContext *ctx);
+
+void server_process_control_requests(ServerContext *ctx)
+{
+    admin_server_update(ctx);
+    server_publish_worker_status(ctx);
+
+    if (ctx->successor_pid)
+        server_poll_successor(ctx);
+
+    if (ctx->restart_requested && *(ctx->restart_requested))
+    {
+        *(ctx->restart_requested) = 0;
+        if (ctx->successor_ready)
+            LOG_WARN("ホットリスタート: 新プロセスの準備完了を待っています");
+        else if (!ctx->draining && !server_hot_restart(ctx))
+            LOG_ERROR("ホットリスタート失敗: このプロセスで受付を続けます");
+    }
+
+    if (ctx->drain_requested && *(ctx->drain_requested) && !ctx->draining)
+        server_begin_drain(ctx);
+}
+
+uint64_t server_control_wake_deadline(const ServerContext *ctx, uint64_t deadline)
+{
+    if (ctx->successor_ready && ctx->successor_ready_deadline < deadline)
+        return ctx->successor_ready_deadline;
+    return deadline;
+}
+
+void server_begin_drain(ServerContext *ctx)
+{
+    if (ctx->draining)
+        return;
+    ctx->draining = true;
+
+    // 次の試合を待っている接続はこのプロセスでは組ませない
+    matchmaking_shutdown(ctx);
+
+    LOG_WARN("ドレイン開始: 新規接続の受付を停止し、進行中の試合の終了を待ちます");
+}
+
+// リスナーをイベントループから外して閉じる（新プロセス側の複製は開いたまま）
+static void close_listener(ServerContext *ctx, TCPsocket *socket)
+{
+    if (!*socket)
+        return;
+    event_loop_remove(&ctx->loop, *socket);
+    SDLNet_TCP_Close(*socket);
+    *socket = nullptr;
+}
+
+#ifndef CLOSE_RANGE_CLOEXEC
+#define CLOSE_RANGE_CLOEXEC (1U << 2)
+#endif
+
+#define SUCCESSOR_MAX_FDS 4
+#define SUCCESSOR_ENV_ENTRY_SIZE 64
+
+// 新プロセスへ引き継ぐディスクリプタと環境変数
+// 管理スレッドがいるとfork後の子ではasync-signal-safeな呼び出ししか使えないため、文字列や配列はforkの前に親で用意する
+struct SuccessorExec
+{
+    char **envp;  // 今の環境から引き継ぎ用の変数を除き、entries を足したもの
+    char entries[SUCCESSOR_MAX_FDS][SUCCESSOR_ENV_ENTRY_SIZE];
+    int fds[SUCCESSOR_MAX_FDS];
+    int fd_count;
+    int max_fd;   // close_range が使えないときに見るディスクリプタの上限
+};
+
+// 引き継ぎに使う環境変数（渡さないものも、自分が受け取った古い値が残らないよう必ず除く）
+static const char *const INHERITED_FD_ENV_NAMES[] = {LISTEN_FD_ENV, SPECTATOR_LISTEN_FD_ENV, RESUME_FORWARD_FD_ENV,
+                                                     RESTART_READY_FD_ENV};
+
+static bool is_inherited_fd_env(const char *entry)
+{
+    for (const char *name : INHERITED_FD_ENV_NAMES)
+    {
+        size_t length = strlen(name);
+        if (strncmp(entry, name, length) == 0 && entry[length] == '=')
+            return true;
+    }
+    return false;
+}
+
+static void successor_add_fd(SuccessorExec *exec, const char *env_name, TCPsocket socket)
+{
+    int fd = network_get_socket_fd(socket);
+    if (fd < 0 || exec->fd_count >= SUCCESSOR_MAX_FDS)
+        return;
+
+    snprintf(exec->entries[exec->fd_count], SUCCESSOR_ENV_ENTRY_SIZE, "%s=%d", env_name, fd);
+    exec->fds[exec->fd_count++] = fd;
+}
+
+static bool successor_prepare(ServerContext *ctx, TCPsocket resume_channel, TCPsocket ready_channel,
+                              SuccessorExec *exec)
+{
+    memset(exec, 0, sizeof(SuccessorExec));
+    successor_add_fd(exec, LISTEN_FD_ENV, ctx->server_socket);
+    successor_add_fd(exec, SPECTATOR_LISTEN_FD_ENV, ctx->spectators.listen_socket);
+    successor_add_fd(exec, RESUME_FORWARD_FD_ENV, resume_channel);
+    successor_add_fd(exec, RESTART_READY_FD_ENV, ready_channel);
+
+    int env_count = 0;
+    while (environ[env_count])
+        env_count++;
+
+    exec->envp = (char **)malloc(sizeof(char *) * (size_t)(env_count + exec->fd_count + 1));
+    if (!exec->envp)
+        return false;
+
+    int count = 0;
+    for (int i = 0; i < env_count; i++)
+    {
+        if (!is_inherited_fd_env(environ[i]))
+            exec->envp[count++] = environ[i];
+    }
+    for (int i = 0; i < exec->fd_count; i++)
+        exec->envp[count++] = exec->entries[i];
+    exec->envp[count] = nullptr;
+
+    long max_fd = sysconf(_SC_OPEN_MAX);
+    exec->max_fd = (max_fd > 0 && max_fd < 65536) ? (int)max_fd : 65536;
+    return true;
+}
+
+// 子プロセス側（async-signal-safeな呼び出しのみ）:
+// クライアントのソケットやepollを新プロセスへ漏らさないようすべてexec時に閉じる設定にしてから、
+// 引き継ぐディスクリプタだけを戻してexecする
+static void exec_successor(char *const argv[], const SuccessorExec *exec, int error_pipe)
+{
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, 3U, ~0U, CLOSE_RANGE_CLOEXEC) < 0)
+#endif
+    {
+        for (int fd = 3; fd < exec->max_fd; fd++)
+        {
+            int flags = fcntl(fd, F_GETFD);
+            if (flags >= 0)
+                fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+        }
+    }
+
+    bool kept = true;
+    for (int i = 0; i < exec->fd_count; i++)
+    {
+        int flags = fcntl(exec->fds[i], F_GETFD);
+        if (flags < 0 || fcntl(exec->fds[i], F_SETFD, flags & ~FD_CLOEXEC) < 0)
+            kept = false;
+    }
+
+    if (kept)
+        execve("/proc/self/exe", argv, exec->envp);
+
+    // 失敗を親へ知らせる
+    int error = errno;
+    ssize_t written = write(error_pipe, &error, sizeof(error));
+    (void)written;
+    _exit(127);
+}
+
+void server_close_successor_channels(ServerContext *ctx)
+{
+    if (ctx->successor_ready)
+    {
+        event_loop_remove(&ctx->loop, ctx->successor_ready);
+        SDLNet_TCP_Close(ctx->successor_ready);
+        ctx->successor_ready = nullptr;
+    }
+    if (ctx->successor_resume_inbox)
+    {
+        SDLNet_TCP_Close(ctx->successor_resume_inbox);
+        ctx->successor_resume_inbox = nullptr;
+    }
+}
+
+static void log_successor_exit(pid_t pid, int status)
+{
+    if (WIFEXITED(status))
+        LOG_ERROR("ホットリスタート: 新プロセス (pid " << pid << ") が終了コード " << WEXITSTATUS(status) << " で終了");
+    else if (WIFSIGNALED(status))
+        LOG_ERROR("ホットリスタート: 新プロセス (pid " << pid << ") がシグナル " << WTERMSIG(status) << " で終了");
+}
+
+// 新プロセスが準備できなかった: 止めて、リスナーを持ったままこのプロセスで受付を続ける
+static void successor_rollback(ServerContext *ctx, const char *reason)
+{
+    LOG_ERROR("ホットリスタート失敗: " << reason << "。このプロセスで受付を続けます");
+    server_close_successor_channels(ctx);
+
+    // 通知前の新プロセスはまだ接続を受けていない（試合を持たない）ので、確実に止めて回収する
+    if (ctx->successor_pid)
+    {
+        kill(ctx->successor_pid, SIGKILL);
+        int status = 0;
+        while (waitpid(ctx->successor_pid, &status, 0) < 0 && errno == EINTR)
+            ;
+        if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGKILL)
+            log_successor_exit(ctx->successor_pid, status);
+        ctx->successor_pid = 0;
+    }
+}
+
+// 新プロセスがリスナーを開き終えた: 受付を渡してドレインに入る
+static void successor_take_over(ServerContext *ctx)
+{
+    LOG_SUCCESS("ホットリスタート: 新プロセス (pid " << ctx->successor_pid << ") の準備完了");
+
+    // 同じリスナーを両プロセスで待つとacceptを奪い合うため、こちらは手放す
+    // 以降この試合への再接続は新プロセスが受け、resume_inbox 経由でこちらへ戻ってくる
+    close_listener(ctx, &ctx->server_socket);
+    close_listener(ctx, &ctx->spectators.listen_socket);
+
+    ctx->resume_inbox = ctx->successor_resume_inbox;
+    ctx->successor_resume_inbox = nullptr;
+    event_loop_add_listener(&ctx->loop, ctx->resume_inbox);
+    server_close_successor_channels(ctx);
+
+    server_begin_drain(ctx);
+}
+
+// 新プロセスの準備完了・終了・タイムアウトを確認する（制御要求の処理ごとに呼ぶ）
+static void server_poll_successor(ServerContext *ctx)
+{
+    int status = 0;
+    pid_t exited = waitpid(ctx->successor_pid, &status, WNOHANG);
+    if (exited == ctx->successor_pid)
+    {
+        log_successor_exit(exited, status);
+        ctx->successor_pid = 0;
+    }
+
+    if (!ctx->successor_ready)
+        return;
+
+    // 準備完了は1バイト、通知前に終了すれば経路のEOF
+    char ready = 0;
+    ssize_t got = recv(network_get_socket_fd(ctx->successor_ready), &ready, sizeof(ready), MSG_DONTWAIT);
+    if (got > 0)
+    {
+        if (ctx->successor_pid)
+            successor_take_over(ctx);
+        else
+            successor_rollback(ctx, "新プロセスが準備完了の直後に終了");
+    }
+    else if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) || !ctx->successor_pid)
+    {
+        successor_rollback(ctx, "新プロセスが準備完了前に終了");
+    }
+    else if (event_loop_now_ns() >= ctx->successor_ready_deadline)
+    {
+        successor_rollback(ctx, "新プロセスの準備完了を待つ時間を過ぎた");
+    }
+}
+
+bool server_hot_restart(ServerContext *ctx)
+{
+    if (!ctx->argv)
+        return false;
+
+    // 新プロセスが受けたこのプロセスの試合への再接続を、こちらへ戻してもらう経路
+    TCPsocket resume_inbox, resume_channel;
+    if (!network_open_fd_channel(&resume_inbox, &resume_channel))
+        return false;
+
+    // 新プロセスがリスナーを開き終えたら1バイト書いてもらう経路（それまでリスナーは手放さない）
+    TCPsocket ready_inbox, ready_channel;
+    if (!network_open_fd_channel(&ready_inbox, &ready_channel))
+    {
+        SDLNet_TCP_Close(resume_inbox);
+        SDLNet_TCP_Close(resume_channel);
+        return false;
+    }
+
+    SuccessorExec exec;
+    if (!successor_prepare(ctx, resume_channel, ready_channel, &exec))
+    {
+        LOG_ERROR("ホットリスタート: 環境変数を用意できません");
+        SDLNet_TCP_Close(resume_inbox);
+        SDLNet_TCP_Close(resume_channel);
+        SDLNet_TCP_Close(ready_inbox);
+        SDLNet_TCP_Close(ready_channel);
+        return false;
+    }
+
+    // exec成功はパイプのEOF（O_CLOEXECで閉じる）、失敗はerrnoの書き込みで判別する
+    int error_pipe[2];
+    if (pipe2(error_pipe, O_CLOEXEC) < 0)
+    {
+        LOG_ERROR("ホットリスタート: pipe失敗: " << strerror(errno));
+        free(exec.envp);
+        SDLNet_TCP_Close(resume_inbox);
+        SDLNet_TCP_Close(resume_channel);
+        SDLNet_TCP_Close(ready_inbox);
+        SDLNet_TCP_Close(ready_channel);
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        LOG_ERROR("ホットリスタート: fork失敗: " << strerror(errno));
+        close(error_pipe[0]);
+        close(error_pipe[1]);
+        free(exec.envp);
+        SDLNet_TCP_Close(resume_inbox);
+        SDLNet_TCP_Close(resume_channel);
+        SDLNet_TCP_Close(ready_inbox);
+        SDLNet_TCP_Close(ready_channel);
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        close(error_pipe[0]);
+        exec_successor(ctx->argv, &exec, error_pipe[1]);
+    }
+
+    free(exec.envp);
+    SDLNet_TCP_Close(resume_channel);
+    SDLNet_TCP_Close(ready_channel);
+    close(error_pipe[1]);
+    int child_error = 0;
+    ssize_t got;
+    do
+    {
+        got = read(error_pipe[0], &child_error, sizeof(child_error));
+    } while (got < 0 && errno == EINTR);
+    close(error_pipe[0]);
+
+    if (got > 0)
+    {
+        LOG_ERROR("ホットリスタート: exec失敗: " << strerror(child_error));
+        while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR)
+            ;
+        SDLNet_TCP_Close(resume_inbox);
+        SDLNet_TCP_Close(ready_inbox);
+        return false;
+    }
+
+    LOG_SUCCESS("ホットリスタート: 新プロセス起動 (pid " << pid << ")、準備完了を待ちます");
+
+    // 準備完了（または通知前の終了によるEOF）でループが起きるよう登録し、結果は server_poll_successor で見る
+    ctx->successor_pid = pid;
+    ctx->successor_ready = ready_inbox;
+    ctx->successor_resume_inbox = resume_inbox;
+    ctx->successor_ready_deadline = event_loop_now_ns() + (uint64_t)HOT_RESTART_READY_TIMEOUT_MS * 1000000ULL;
+    event_loop_add_listener(&ctx->loop, ctx->successor_ready);
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "server_context.h"
+
+// シグナルで受けたドレイン・ホットリスタート要求を処理する
+// 待機ループ・メインループの各周回で呼ぶ
+void server_process_control_requests(ServerContext *ctx);
+
+// ドレイン開始: マッチング待機中の接続を閉じ、以降の新規接続を断る
+// 進行中の試合はそのまま最後まで続け、猶予期間中のプレイヤーの再接続も受け付ける
+// （ホットリスタート後はリスナーを新プロセスが持つので、再接続は新プロセスから転送されてくる）
+void server_begin_drain(ServerContext *ctx);
+
+// 同じ起動引数で新しいサーバープロセスを起動し、リスナーと再接続の転送経路を引き継がせる
+// 新プロセスがリスナーを開き終えたと知らせてきたら、自プロセスはリスナーを閉じてドレインに入り、
+// 自分の試合への再接続だけを転送経路から受け取る（通知前に新プロセスが終了するか時間切れなら、止めて受付を続ける）
+// 戻り値: 新プロセスのexecに成功した場合true（準備完了の確認は server_process_control_requests で行う）
+bool server_hot_restart(ServerContext *ctx);
+
+// ホットリスタートの準備完了待ちに使う経路を閉じる（待っていなければ何もしない）
+void server_close_successor_channels(ServerContext *ctx);
+
+// ホットリスタートの準備完了待ちの間は、その期限までに起きるよう deadline を切り詰める
+uint64_t server_control_wake_deadline(const ServerContext *ctx, uint64_t deadline);
@@ -0,0 +1,97 @@
+#include "server_events.h"
+#include "log.h"
+#include "game/score_logic.h"
+#include "server_broadcast.h"
+
+// イベントの受け手（イベント列をまとめて受け取る）
+typedef void (*GameEventSubscriber)(ServerContext *ctx, const GameEvent *events, int count);
+
+static void stats_on_events(ServerContext *ctx, const GameEvent *events, int count)
+{
+    match_stats_apply(&ctx->match_stats, events, count);
+}
+
+static void log_match_summary(const ServerContext *ctx)
+{
+    const MatchStats *stats = &ctx->match_stats;
+    LOG_INFO("試合統計: 得点 " << stats->points_won[0] << "-" << stats->points_won[1]
+             << ", ラリー " << stats->rallies << " 回 (平均 "
+             << (stats->rallies > 0 ? (float)stats->total_rally_hits / (float)stats->rallies : 0.0f)
+             << " 打, 最長 " << stats->longest_rally << " 打), 能力 " << stats->ability_changes << " 回");
+}
+
+static void log_on_events(ServerContext *ctx, const GameEvent *events, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const GameEvent *event = &events[i];
+        switch (event->type)
+        {
+            case GAME_EVENT_POINT_SCORED:
+                print_score(&ctx->state.score);
+                break;
+            case GAME_EVENT_BALL_HIT:
+                LOG_DEBUG("プレイヤー " << event->player_id << " が打球 (種類 " << event->value << ")");
+                break;
+            case GAME_EVENT_PHASE_CHANGED:
+                if (event->value == (int)GAME_PHASE_GAME_FINISHED)
+                    log_match_summary(ctx);
+                break;
+            case GAME_EVENT_ABILITY_CHANGED:
+                break;
+        }
+    }
+}
+
+// スコアと能力は複数のイベントがあっても1tickに1回ずつ送る
+static void broadcast_on_events(ServerContext *ctx, const GameEvent *events, int count)
+{
+    bool score_changed = false;
+    uint32_t ability_changed = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (events[i].type == GAME_EVENT_POINT_SCORED)
+            score_changed = true;
+        else if (events[i].type == GAME_EVENT_ABILITY_CHANGED && events[i].player_id >= 0 && events[i].player_id < MAX_CLIENTS)
+            ability_changed |= 1u << events[i].player_id;
+    }
+
+    if (score_changed)
+        broadcast_score_update(ctx);
+    for (int i = 0; ability_changed != 0; i++, ability_changed >>= 1)
+    {
+        if (ability_changed & 1u)
+            broadcast_ability_state(ctx, i);
+    }
+
+    // フェーズ・試合結果は送信済みの値と比べて送る（イベントを経ずに変わった場合も拾う）
+    broadcast_phase_update(ctx);
+    if (ctx->state.phase == GAME_PHASE_GAME_FINISHED && !ctx->state.match_result_sent)
+    {
+        broadcast_match_result(ctx, ctx->state.match_winner);
+        ctx->state.match_result_sent = true;
+    }
+}
+
+// 統計はログより先に更新する（試合終了のログで使う）
+static const GameEventSubscriber SUBSCRIBERS[] = {
+    stats_on_events,
+    log_on_events,
+    broadcast_on_events,
+};
+
+void server_events_dispatch(ServerContext *ctx)
+{
+    GameEventQueue *queue = &ctx->state.events;
+    GameEvent events[GAME_EVENT_QUEUE_SIZE];
+    int count = game_events_drain(queue, events);
+
+    if (queue->dropped > 0)
+    {
+        LOG_WARN("試合イベントを " << queue->dropped << " 件捨てました（キュー満杯）");
+        queue->dropped = 0;
+    }
+
+    for (const GameEventSubscriber subscriber : SUBSCRIBERS)
+        subscriber(ctx, events, count);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "server_context.h"
+
+// このtickに溜まった試合イベントを、登録された受け手（統計・ログ・送信）へ順にまとめて渡す
+// シミュレーションtickの後に1回呼ぶ（フェーズ・スコア・試合結果の送信もここで行う）
+void server_events_dispatch(ServerContext *ctx);
@@ -1,78 +1,224 @@
 #include "server_init.h"
+#include <errno.h>
 #include <string.h>
+#include <sys/socket.h>
 #include "log.h"
 #include "common/game_constants.h"
 #include "game/game_phase_manager.h"
+#include "server_broadcast.h"
+#include "server_session.h"
+#include "server_matchmaking.h"
+#include "server_drain.h"
 #include "../server_constants.h"
 
-bool server_initialize(ServerContext *ctx, int port)
+bool server_initialize(ServerContext *ctx, const ServerConfig *config, int worker_channel_fd)
 {
     memset(ctx, 0, sizeof(ServerContext));
+    ctx->config = *config;
+
+    if (!event_loop_init(&ctx->loop))
+        return false;
+
+    ctx->checkpoint.fd = -1;
+    if (config->checkpoint_path[0] != '\0' && !checkpoint_open(&ctx->checkpoint, config->checkpoint_path))
+        return false;
 
     ctx->last_sent_phase = (GamePhase)GAME_SCORE_INVALID;
-    ctx->last_sent_score.point_p1 = GAME_SCORE_INVALID;
-    ctx->last_sent_score.point_p2 = GAME_SCORE_INVALID;
-    ctx->last_sent_score.sets_p1 = GAME_SCORE_INVALID;
-    ctx->last_sent_score.sets_p2 = GAME_SCORE_INVALID;
 
-    ctx->server_socket = network_init_server(port);
-    if (!ctx->server_socket)
-    {
-        LOG_ERROR("サーバーソケット初期化失敗");
+    if (config->admin_socket_path[0] != '\0' && !admin_server_start(&ctx->admin, config->admin_socket_path, ctx->loop.wake_fd))
         return false;
+
+    if (worker_channel_fd >= 0)
+    {
+        // ワーカー: リスナーは受付プロセスだけが持ち、接続はこの経路で振り分けられてくる
+        if (SDLNet_Init() < 0)
+        {
+            LOG_ERROR("SDLNet初期化失敗: " << SDLNet_GetError());
+            return false;
+        }
+        ctx->worker_inbox = network_wrap_fd_channel(worker_channel_fd);
+        if (!ctx->worker_inbox)
+        {
+            LOG_ERROR("受付プロセスとの経路が無効");
+            return false;
+        }
     }
+    else
+    {
+        ctx->server_socket = network_init_server(config->port);
+        if (!ctx->server_socket)
+        {
+            LOG_ERROR("サーバーソケット初期化失敗");
+            return false;
+        }
 
-    init_game(&ctx->state);
+        if (!spectator_init(&ctx->spectators, config->spectator_port))
+        {
+            LOG_ERROR("観戦者リスナー初期化失敗");
+            return false;
+        }
+    }
+
+    rate_limiter_init(&ctx->accept_limiter, ACCEPT_RATE_PER_SEC, ACCEPT_BURST, SDL_GetTicks());
+    rate_limiter_init(&ctx->spectator_accept_limiter, ACCEPT_RATE_PER_SEC, ACCEPT_BURST, SDL_GetTicks());
+
+    matchmaking_init(&ctx->matchmaking);
+    init_game(&ctx->state, server_config_match_players(&ctx->config), &ctx->config.score_format, ctx->config.court_surface);
+    ctx->court = court_physics(ctx->state.surface);
     init_phase_manager(&ctx->state);
 
-    ctx->socket_set = SDLNet_AllocSocketSet(MAX_CLIENTS + 1);
-    if (!ctx->socket_set)
-    {
-        LOG_ERROR("ソケットセット作成失敗");
+    if (ctx->server_socket && !event_loop_add_listener(&ctx->loop, ctx->server_socket))
         return false;
+    if (ctx->spectators.listen_socket && !event_loop_add_listener(&ctx->loop, ctx->spectators.listen_socket))
+        return false;
+    if (ctx->worker_inbox && !event_loop_add_listener(&ctx->loop, ctx->worker_inbox))
+        return false;
+
+    // ホットリスタートで起動された場合、旧プロセスの試合への再接続はここから旧プロセスへ渡す
+    ctx->resume_forward = network_adopt_fd_channel(RESUME_FORWARD_FD_ENV);
+
+    // リスナーの準備ができたことを旧プロセスへ知らせる（届くまで旧プロセスはリスナーを閉じない）
+    TCPsocket restart_ready = network_adopt_fd_channel(RESTART_READY_FD_ENV);
+    if (restart_ready)
+    {
+        const char ready = 1;
+        if (send(network_get_socket_fd(restart_ready), &ready, sizeof(ready), MSG_DONTWAIT | MSG_NOSIGNAL) != 1)
+            LOG_WARN("旧プロセスへ準備完了を通知できません: " << strerror(errno));
+        SDLNet_TCP_Close(restart_ready);
     }
 
-    SDLNet_TCP_AddSocket(ctx->socket_set, ctx->server_socket);
     LOG_SUCCESS("サーバー初期化完了");
     return true;
 }
 
+bool server_admit_player(ServerContext *ctx, TCPsocket socket)
+{
+    // 受付レートを超えた接続は即座に閉じる（待たせるとリスナーが通知され続ける）
+    if (!rate_limiter_try_consume(&ctx->accept_limiter, SDL_GetTicks()))
+    {
+        ctx->rejected_accepts++;
+        SDLNet_TCP_Close(socket);
+        return false;
+    }
+
+    // 再接続待ちのスロットがあれば、新規接続は再接続要求として扱う
+    if (session_match_paused(ctx))
+    {
+        session_add_pending(ctx, socket);
+        return false;
+    }
+
+    // ドレイン中は進行中の試合への再接続以外を断る
+    if (ctx->draining)
+    {
+        SDLNet_TCP_Close(socket);
+        return false;
+    }
+
+    // スロットへは直接入れず、マッチング待機列を経由する
+    matchmaking_enqueue_client(ctx, socket);
+    return true;
+}
+
+void server_admit_spectator(ServerContext *ctx, TCPsocket socket)
+{
+    if (ctx->draining || !rate_limiter_try_consume(&ctx->spectator_accept_limiter, SDL_GetTicks()))
+    {
+        if (!ctx->draining)
+            ctx->rejected_accepts++;
+        SDLNet_TCP_Close(socket);
+        return;
+    }
+
+    if (spectator_add(&ctx->spectators, socket))
+        send_full_snapshot(ctx, socket);
+}
+
+// ワーカー: 受付プロセスが振り分けてきた接続を受け取る
+static void server_receive_worker_handoffs(ServerContext *ctx)
+{
+    TCPsocket socket;
+    WorkerHandoff handoff;
+    int result;
+    while ((result = network_receive_fd(ctx->worker_inbox, &socket, &handoff, sizeof(handoff))) > 0)
+    {
+        if (handoff.kind == WORKER_HANDOFF_SPECTATOR)
+            server_admit_spectator(ctx, socket);
+        else
+            server_admit_player(ctx, socket);
+    }
+
+    // 受付プロセスがいなくなれば新しい接続は来ないので、今の試合を終えたら止まる
+    if (result < 0)
+    {
+        LOG_WARN("受付プロセスとの経路が閉じました: 進行中の試合の終了後に停止します");
+        event_loop_remove(&ctx->loop, ctx->worker_inbox);
+        SDLNet_TCP_Close(ctx->worker_inbox);
+        ctx->worker_inbox = nullptr;
+        server_begin_drain(ctx);
+    }
+}
+
+void server_accept_connections(ServerContext *ctx)
+{
+    if (SDLNet_SocketReady(ctx->server_socket))
+    {
+        TCPsocket socket = SDLNet_TCP_Accept(ctx->server_socket);
+        if (socket)
+            server_admit_player(ctx, socket);
+    }
+
+    if (SDLNet_SocketReady(ctx->spectators.listen_socket))
+    {
+        TCPsocket socket = SDLNet_TCP_Accept(ctx->spectators.listen_socket);
+        if (socket)
+            server_admit_spectator(ctx, socket);
+    }
+
+    if (SDLNet_SocketReady(ctx->worker_inbox))
+        server_receive_worker_handoffs(ctx);
+}
+
 bool server_wait_for_clients(ServerContext *ctx)
 {
-    SDLNet_SocketSet wait_set = SDLNet_AllocSocketSet(1);
-    if (!wait_set)
+    // ドレイン中は次の試合を始めない
+    server_process_control_requests(ctx);
+    if (ctx->draining)
     {
-        LOG_ERROR("待機用ソケットセット作成失敗");
+        LOG_INFO("ドレイン中のため待機終了");
         return false;
     }
-    SDLNet_TCP_AddSocket(wait_set, ctx->server_socket);
 
+    server_fill_ai_slots(ctx, SDL_GetTicks());
+
+    // 前の試合中に待機列へ入った接続から先に組ませる
+    matchmaking_fill_slots(ctx);
     int connected_count = count_connected_clients(ctx->players);
-    int player_id = connected_count;
 
-    while (connected_count < MAX_CLIENTS && *(ctx->running))
+    while (connected_count < server_config_match_players(&ctx->config) && *(ctx->running))
     {
-        int ready = SDLNet_CheckSockets(wait_set, SOCKET_TIMEOUT_INIT_WAIT_MS);
+        // 待機者がいる間は許容範囲の拡大とレーティング通知の期限に合わせて起き、いなければ接続かシグナルまで眠る
+        uint64_t deadline = server_control_wake_deadline(ctx, matchmaking_wake_deadline(ctx, event_loop_now_ns()));
+
+        int ready = event_loop_wait(&ctx->loop, deadline);
         if (ready < 0)
         {
             LOG_ERROR("ソケットチェック失敗");
-            SDLNet_FreeSocketSet(wait_set);
             return false;
         }
 
-        if (ready > 0 && SDLNet_SocketReady(ctx->server_socket))
+        server_process_control_requests(ctx);
+        if (ctx->draining)
         {
-            TCPsocket new_socket = network_accept_client(ctx->server_socket, ctx->players, ctx->connections);
-            if (new_socket)
-            {
-                SDLNet_TCP_AddSocket(ctx->socket_set, new_socket);
-                player_id++;
-                connected_count = count_connected_clients(ctx->players);
-            }
+            LOG_INFO("ドレイン中のため待機終了");
+            return false;
         }
-    }
 
-    SDLNet_FreeSocketSet(wait_set);
+        server_accept_connections(ctx);
+        matchmaking_poll_clients(ctx);
+        matchmaking_fill_slots(ctx);
+        connected_count = count_connected_clients(ctx->players);
+    }
 
     if (!*(ctx->running))
     {
@@ -88,18 +234,94 @@ bool server_wait_for_clients(ServerContext *ctx)
         {
             Packet packet = create_packet_player_id(i);
             network_send_packet(ctx->connections[i].socket, &packet);
+            session_issue_token(ctx, i);
         }
     }
     return true;
 }
 
+bool server_restore_checkpoint(ServerContext *ctx)
+{
+    const CheckpointData *data = checkpoint_latest(&ctx->checkpoint);
+    if (!data)
+        return false;
+
+    ctx->state = data->state;
+    ctx->court = court_physics(ctx->state.surface);
+    memcpy(ctx->ai_players, data->ai_players, sizeof(ctx->ai_players));
+    ctx->ability_frame_time = data->ability_frame_time;
+    ctx->server_tick = data->server_tick;
+
+    // 人間のプレイヤーは旧プロセスで発行済みのトークンで再接続してくるまで保留する
+    Uint32 now = SDL_GetTicks();
+    int restored = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        ClientConnection *connection = &ctx->connections[i];
+        connection->player_id = i;
+
+        if (ctx->ai_players[i].enabled)
+        {
+            ctx->players[i].connected = true;
+        }
+        else if (data->session_tokens[i] != 0)
+        {
+            ctx->players[i].connected = true;
+            connection->session_token = data->session_tokens[i];
+            connection->suspended = true;
+            connection->suspended_at_ms = now;
+        }
+        else
+        {
+            continue;
+        }
+        ctx->players[i].player_id = i;
+        restored++;
+    }
+
+    if (restored == 0)
+    {
+        checkpoint_clear(&ctx->checkpoint);
+        return false;
+    }
+
+    ctx->resumed_match = true;
+    LOG_SUCCESS("チェックポイントから試合を再開 (プレイヤー " << restored << " 人)");
+    return true;
+}
+
+void server_fill_ai_slots(ServerContext *ctx, uint32_t seed)
+{
+    int remaining = ctx->config.ai_players;
+
+    for (int i = server_config_match_players(&ctx->config) - 1; i >= 0 && remaining > 0; i--, remaining--)
+    {
+        ctx->players[i].connected = true;
+        ctx->players[i].player_id = i;
+        ctx->connections[i].socket = nullptr;
+        ctx->connections[i].player_id = i;
+        ai_player_init(&ctx->ai_players[i], AI_DEFAULT_SKILL, seed * 2654435761u + (uint32_t)i + 1u);
+        LOG_INFO("AIプレイヤー (スロット " << i << ")");
+    }
+}
+
 void server_cleanup(ServerContext *ctx)
 {
-    if (ctx->socket_set)
+    admin_server_stop(&ctx->admin);
+    session_reset(ctx);
+    session_close_resume_channels(ctx);
+    server_close_successor_channels(ctx);
+    if (ctx->worker_inbox)
     {
-        SDLNet_FreeSocketSet(ctx->socket_set);
-        ctx->socket_set = NULL;
+        SDLNet_TCP_Close(ctx->worker_inbox);
+        ctx->worker_inbox = nullptr;
     }
+    matchmaking_shutdown(ctx);
+    checkpoint_close(&ctx->checkpoint);
+
+    event_loop_shutdown(&ctx->loop);
+
+    spectator_shutdown(&ctx->spectators);
 
     if (ctx->server_socket)
     {
@@ -112,25 +334,33 @@ void server_cleanup(ServerContext *ctx)
 
 void server_reset_for_new_game(ServerContext *ctx)
 {
+    session_reset(ctx);
+
+    // 終わった試合をチェックポイントから再開しないようにする
+    checkpoint_clear(&ctx->checkpoint);
+    ctx->resumed_match = false;
+
     for (int i = 0; i < MAX_CLIENTS; i++)
     {
         if (ctx->connections[i].socket)
         {
-            SDLNet_TCP_DelSocket(ctx->socket_set, ctx->connections[i].socket);
+            event_loop_remove(&ctx->loop, ctx->connections[i].socket);
             SDLNet_TCP_Close(ctx->connections[i].socket);
             ctx->connections[i].socket = NULL;
         }
         ctx->players[i].connected = false;
     }
 
-    init_game(&ctx->state);
+    init_game(&ctx->state, server_config_match_players(&ctx->config), &ctx->config.score_format, ctx->config.court_surface);
+    ctx->court = court_physics(ctx->state.surface);
     init_phase_manager(&ctx->state);
 
+    memset(ctx->ai_players, 0, sizeof(ctx->ai_players));
+    memset(ctx->player_state_dirty, 0, sizeof(ctx->player_state_dirty));
+    memset(ctx->player_state_idle_ticks, 0, sizeof(ctx->player_state_idle_ticks));
+    ctx->last_sent_extra_ball_count = 0;
+
     ctx->last_sent_phase = (GamePhase)GAME_SCORE_INVALID;
-    ctx->last_sent_score.point_p1 = GAME_SCORE_INVALID;
-    ctx->last_sent_score.point_p2 = GAME_SCORE_INVALID;
-    ctx->last_sent_score.sets_p1 = GAME_SCORE_INVALID;
-    ctx->last_sent_score.sets_p2 = GAME_SCORE_INVALID;
 
     LOG_SUCCESS("ゲームリセット完了");
 }
@@ -4,15 +4,35 @@
 
 // サーバー初期化
 // SDL、ネットワーク、ゲーム状態を初期化する
-// port: サーバーがリッスンするポート番号
+// config: 実行時設定（ポート番号・更新レートなど、コンテキストへコピーされる）
+// worker_channel_fd: ワーカーとして受付プロセスから接続を受け取る経路（-1: 自分でリスナーを開く）
 // 戻り値: 成功時true、失敗時false
-bool server_initialize(ServerContext *ctx, int port);
+bool server_initialize(ServerContext *ctx, const ServerConfig *config, int worker_channel_fd);
+
+// リスナー（ワーカーでは受付プロセスとの経路）に届いた接続を受け付ける
+void server_accept_connections(ServerContext *ctx);
+
+// 受け付けたプレイヤーの接続を処理する（受付レート超過とドレイン中は切断、再接続待ち中は再接続要求として保留）
+// 通常の接続はマッチング待機列へ入り、matchmaking_fill_slots でスロットに割り当てられる
+// 戻り値: 待機列に追加した場合true
+bool server_admit_player(ServerContext *ctx, TCPsocket socket);
+
+// 受け付けた観戦者の接続を加え、現在の状態を送信する
+void server_admit_spectator(ServerContext *ctx, TCPsocket socket);
 
 // クライアント接続待機
-// 必要人数（MAX_CLIENTS）のクライアントが接続するまで待機
-// 戻り値: 成功時true、中断時false
+// マッチング待機列から必要人数（シングルス2人、ダブルス4人）のスロットが埋まるまで待機
+// 戻り値: 成功時true、中断時・ドレイン中はfalse
 bool server_wait_for_clients(ServerContext *ctx);
 
+// チェックポイントに残っている試合を復元する
+// 人間のプレイヤーは再接続待ち（猶予期間つき）として保持し、試合は一時停止した状態で始まる
+// 戻り値: 再開する試合があればtrue
+bool server_restore_checkpoint(ServerContext *ctx);
+
+// 設定された人数のAIプレイヤーで後ろのスロットから埋める
+void server_fill_ai_slots(ServerContext *ctx, uint32_t seed);
+
 // サーバークリーンアップ
 // ネットワークリソースを解放し、SDLをシャットダウン
 void server_cleanup(ServerContext *ctx);
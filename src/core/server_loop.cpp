@@ -1,79 +1,300 @@
 #include "server_loop.h"
+#include <string.h>
 #include <SDL2/SDL.h>
 #include "log.h"
 #include "game/game_phase_manager.h"
 #include "common/game_constants.h"
-#include "common/ability.h"
+#include "game/ability_engine.h"
 #include "server_broadcast.h"
+#include "server_events.h"
 #include "game_update.h"
+#include "server_init.h"
+#include "server_session.h"
+#include "server_matchmaking.h"
+#include "server_drain.h"
+#include "server_config.h"
+#include "event_loop.h"
 #include "../server_constants.h"
 
+// 能力の持続時間を1ゲームフレーム進め、切れた能力をイベントにする
 static void update_ability_states(ServerContext *ctx)
 {
-    for (int i = 0; i < MAX_CLIENTS; i++)
+    uint32_t expired = ability_engine_tick(&ctx->state.ability_engine, ctx->state.ability_states);
+    for (int i = 0; expired != 0; i++, expired >>= 1)
     {
-        AbilityState *state = &ctx->state.ability_states[i];
+        if (expired & 1u)
+            game_events_push(&ctx->state.events, GAME_EVENT_ABILITY_CHANGED, i, -1, 0);
+    }
+}
 
-        if (state->active_ability == ABILITY_GIANT || state->active_ability == ABILITY_CLONE)
-            continue;
+// 受信制限・不正な入力が検出されたクライアントを定期的にログへ出す
+// 間隔を空けてまとめて出すので、--debug-log なしでも出力する
+static void report_client_warnings(ServerContext *ctx)
+{
+    Uint32 now = SDL_GetTicks();
+    if ((int)(now - ctx->last_throttle_report_ms) < THROTTLE_REPORT_INTERVAL_MS)
+        return;
+    ctx->last_throttle_report_ms = now;
+
+    uint32_t rejected = ctx->rejected_accepts - ctx->reported_rejected_accepts;
+    if (rejected > 0)
+    {
+        LOG_REPORT("接続受付レート超過: " << rejected << " 件を切断 (累計 " << ctx->rejected_accepts << ")");
+        ctx->reported_rejected_accepts = ctx->rejected_accepts;
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        ClientConnection *connection = &ctx->connections[i];
 
-        if (state->remaining_frames > 0)
+        if (input_validator_take_report(&connection->input_validator) > 0)
         {
-            state->remaining_frames--;
-            if (state->remaining_frames == 0)
-            {
-                state->active_ability = ABILITY_NONE;
-                broadcast_ability_state(ctx, i);
-            }
+            const InputValidator *validator = &connection->input_validator;
+            LOG_REPORT("クライアント " << i << " 不正な入力: スイング " << validator->rejected_swings
+                       << " を破棄, 不自然なスイング " << validator->flagged_swings << " (累計)");
         }
+
+        uint32_t deferred = connection->packets_deferred_ticks - connection->reported_deferred_ticks;
+        if (deferred == 0)
+            continue;
+
+        LOG_REPORT("クライアント " << i << " 受信制限中: 読み残しtick " << deferred
+                 << " (累計 " << connection->packets_deferred_ticks
+                 << ", 受信 " << connection->packets_received << ")");
+        connection->reported_deferred_ticks = connection->packets_deferred_ticks;
+    }
+}
+
+// 接続中のクライアントへ定期的にpingを送る
+static void ping_clients(ServerContext *ctx)
+{
+    Uint32 now = SDL_GetTicks();
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        ClientConnection *connection = &ctx->connections[i];
+        if (!connection->socket || !link_quality_ping_due(&connection->link_quality, now))
+            continue;
+
+        PingPayload ping = link_quality_on_ping_sent(&connection->link_quality, now);
+        Packet packet = create_packet_ping(&ping);
+        network_send_packet_to(connection, &packet);
+    }
+}
+
+// 各クライアントの接続品質を定期的にログへ出す（間隔が長いので --debug-log なしでも出す）
+static void report_link_quality(ServerContext *ctx)
+{
+    Uint32 now = SDL_GetTicks();
+    if ((int)(now - ctx->last_link_report_ms) < LINK_QUALITY_REPORT_INTERVAL_MS)
+        return;
+    ctx->last_link_report_ms = now;
+
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        const ClientConnection *connection = &ctx->connections[i];
+        const LinkQuality *quality = &connection->link_quality;
+        if (!connection->socket || !quality->has_rtt)
+            continue;
+
+        const SnapshotPacer *pacer = &connection->snapshot_pacer;
+        LOG_REPORT("クライアント " << i << " RTT " << quality->rtt_ms << " ms, ジッター " << quality->jitter_ms
+                   << " ms, 損失 " << quality->loss * 100.0f << "% (ping " << quality->pings_sent
+                   << " / pong " << quality->pongs_received << "), スナップショット 1/" << pacer->interval
+                   << " (破棄 " << pacer->skipped << ", 送信途中 " << pacer->partial_sends << ")");
+    }
+}
+
+// AIプレイヤーがいるか（AIは毎tick操作するので眠れない）
+static bool has_ai_player(const ServerContext *ctx)
+{
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (ctx->ai_players[i].enabled && ctx->players[i].connected)
+            return true;
+    }
+    return false;
+}
+
+// 時間経過以外で状態が変わらないか（次の変化は入力かフェーズ期限のみ）
+static bool is_simulation_idle(const ServerContext *ctx)
+{
+    if (session_match_paused(ctx))
+        return true;
+    if (has_ai_player(ctx) || !player_kinematics_at_rest(&ctx->state.kinematics, ctx->state.player_count))
+        return false;
+    return !is_physics_active_phase(ctx->state.phase) && !ability_engine_has_timers(&ctx->state.ability_engine, ctx->state.ability_states);
+}
+
+// 待機中に次に起きるべき時刻
+static uint64_t idle_deadline(const ServerContext *ctx, uint64_t now)
+{
+    uint64_t deadline = now + (uint64_t)IDLE_LOOP_MAX_SLEEP_MS * 1000000ULL;
+
+    float until_transition = phase_time_until_transition(&ctx->state);
+    if (!session_match_paused(ctx) && until_transition >= 0.0f)
+    {
+        uint64_t transition = now + (uint64_t)(until_transition * 1e9f);
+        if (transition < deadline)
+            deadline = transition;
+    }
+
+    // 受信制限で読み残した入力は新しいイベントを起こさないので、読めるようになる時刻に起きる
+    // （1tickの上限で止めた場合はトークンが残っているので、すぐに起きる）
+    Uint32 now_ms = SDL_GetTicks();
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        const ClientConnection *connection = &ctx->connections[i];
+        if (!ctx->players[i].connected || !connection->socket || !connection->input_deferred)
+            continue;
+
+        uint64_t refill = now + (uint64_t)rate_limiter_ms_until_token(&connection->input_limiter, now_ms) * 1000000ULL;
+        if (refill < deadline)
+            deadline = refill;
+    }
+    return server_control_wake_deadline(ctx, deadline);
+}
+
+// 新規接続とクライアント入力を処理
+static void poll_network(ServerContext *ctx)
+{
+    server_accept_connections(ctx);
+
+    // 次の試合を待つ接続の切断・レーティング通知
+    matchmaking_poll_clients(ctx);
+
+    // クライアントはエッジトリガーなので、読み残しの有無は毎回確認する
+    game_handle_client_input(ctx);
+}
+
+// 試合状態をチェックポイントの裏面へ書いて公開する（数KB以下のコピーのみ）
+static void save_checkpoint(ServerContext *ctx)
+{
+    CheckpointData *data = checkpoint_begin(&ctx->checkpoint);
+    if (!data)
+        return;
+
+    data->state = ctx->state;
+    memcpy(data->ai_players, ctx->ai_players, sizeof(ctx->ai_players));
+    for (int i = 0; i < MAX_CLIENTS; i++)
+        data->session_tokens[i] = ctx->players[i].connected ? ctx->connections[i].session_token : 0;
+    data->ability_frame_time = ctx->ability_frame_time;
+    data->server_tick = ctx->server_tick;
+
+    checkpoint_commit(&ctx->checkpoint);
+}
+
+void server_simulation_step(ServerContext *ctx, float dt)
+{
+    ctx->server_tick++;
+    game_update_ai_players(ctx, dt);
+    game_update_player_movement(ctx, dt);
+    update_phase_timer(&ctx->state, dt, ctx->running);
+    game_update_physics_and_scoring(ctx, dt);
+
+    // 能力の持続時間はゲームフレーム単位なので、シミュレーションレートに依らず進める
+    ctx->ability_frame_time += dt;
+    while (ctx->ability_frame_time >= GameConstants::FRAME_TIME)
+    {
+        update_ability_states(ctx);
+        ctx->ability_frame_time -= GameConstants::FRAME_TIME;
     }
 }
 
 void server_run_main_loop(ServerContext *ctx)
 {
-    const float dt = GameConstants::FRAME_TIME;
+    const ServerConfig *config = &ctx->config;
+    const float sim_dt = 1.0f / (float)config->simulation_hz;
+
+    // 送信間隔（シミュレーションtick数）
+    const int snapshot_interval = server_config_ticks_per(config, config->snapshot_hz);
+    const int spectator_interval = server_config_ticks_per(config, config->spectator_snapshot_hz);
+    const int idle_interval = server_config_idle_broadcast_interval(config);
+    const int checkpoint_interval = server_config_ticks_per(config, config->checkpoint_hz);
 
-    broadcast_initial_player_states(ctx);
-    set_game_phase(&ctx->state, GAME_PHASE_START_GAME);
-    broadcast_score_update(ctx);
+    const uint64_t tick_period = 1000000000ULL / (uint64_t)config->simulation_hz;
+    uint64_t next_tick = event_loop_now_ns();
+    uint64_t last_tick = next_tick;
 
-    LOG_SUCCESS("ゲーム開始");
+    int ticks_until_snapshot = 0;
+    int ticks_until_checkpoint = 0;
+
+    // チェックポイントから再開した試合は、復元した状態のまま続ける
+    if (!ctx->resumed_match)
+    {
+        ctx->ability_frame_time = 0.0f;
+        broadcast_initial_player_states(ctx);
+        set_game_phase(&ctx->state, GAME_PHASE_START_GAME);
+        broadcast_score_update(ctx);
+    }
+    ctx->resumed_match = false;
+
+    LOG_SUCCESS("ゲーム開始 (シミュレーション " << config->simulation_hz << "Hz, 送信 " << config->snapshot_hz << "Hz)");
 
     while (*(ctx->running) != 0)
     {
-        int ready_count = SDLNet_CheckSockets(ctx->socket_set, SOCKET_TIMEOUT_MAIN_LOOP_MS);
+        // 動きのあるフェーズは次のtickまで、止まっているフェーズは入力かフェーズ期限まで眠る
+        bool idle = is_simulation_idle(ctx);
+        uint64_t deadline = idle ? idle_deadline(ctx, event_loop_now_ns()) : next_tick;
 
-        if (ready_count < 0)
-        {
-            LOG_ERROR("ソケットチェック失敗");
+        if (event_loop_wait(&ctx->loop, deadline) < 0)
             break;
-        }
 
-        if (ready_count > 0)
+        server_process_control_requests(ctx);
+        poll_network(ctx);
+
+        uint64_t now = event_loop_now_ns();
+        float dt = sim_dt;
+
+        if (idle)
         {
-            if (SDLNet_SocketReady(ctx->server_socket))
-            {
-                TCPsocket new_socket = network_accept_client(ctx->server_socket, ctx->players, ctx->connections);
-                if (new_socket)
-                    SDLNet_TCP_AddSocket(ctx->socket_set, new_socket);
-            }
-            game_handle_client_input(ctx, dt);
+            // 止まっている間に経過した時間をまとめて1回で進める
+            // （入力で動き出した場合は通常のtickから始める）
+            if (is_simulation_idle(ctx))
+                dt = (float)(now - last_tick) / 1e9f;
+            next_tick = now + tick_period;
+            ticks_until_snapshot = 0;
         }
+        else
+        {
+            if (now < next_tick)
+                continue;
 
-        update_phase_timer(&ctx->state, dt, ctx->running);
-        game_update_physics_and_scoring(ctx, dt);
-        update_ability_states(ctx);
+            // 大きく遅れた場合は追いつこうとせず、現在時刻から数え直す
+            next_tick += tick_period;
+            if (now > next_tick + tick_period * MAX_SIMULATION_CATCHUP_TICKS)
+                next_tick = now + tick_period;
+        }
+        last_tick = now;
 
-        broadcast_ball_state(ctx);
-        broadcast_phase_update(ctx);
+        session_update(ctx);
+        ping_clients(ctx);
+        report_client_warnings(ctx);
+        report_link_quality(ctx);
+
+        // 再接続待ちの間は試合を止める
+        if (!session_match_paused(ctx))
+            server_simulation_step(ctx, dt);
+
+        // フェーズ・スコア・試合結果などの変化は、このtickの分をまとめて受け手へ渡して即座に送る
+        server_events_dispatch(ctx);
+
+        // 位置情報はスナップショットレートで送る
+        if (--ticks_until_snapshot <= 0)
+        {
+            broadcast_begin_snapshot(ctx);
+            broadcast_player_states(ctx, idle_interval);
+            broadcast_ball_state(ctx);
+            ticks_until_snapshot = snapshot_interval;
+        }
 
-        if (ctx->state.phase == GAME_PHASE_GAME_FINISHED && !ctx->state.match_result_sent)
+        if (ctx->checkpoint.file && --ticks_until_checkpoint <= 0)
         {
-            broadcast_match_result(ctx, ctx->state.match_winner);
-            ctx->state.match_result_sent = true;
+            save_checkpoint(ctx);
+            ticks_until_checkpoint = checkpoint_interval;
         }
 
-        SDL_Delay(GameConstants::FRAME_DELAY_MS);
+        // 止まっている間は起床回数自体が少ないので、溜まった変更をすぐ送る
+        spectator_flush(&ctx->spectators, idle ? 1 : spectator_interval);
     }
 
     LOG_INFO("メインループ終了");
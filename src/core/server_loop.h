@@ -6,3 +6,7 @@
 // クライアント入力の処理、物理更新、ブロードキャストを担当
 void server_run_main_loop(ServerContext *ctx);
 
+// シミュレーションを1tick進める
+// AIの操作、フェーズタイマー、物理・得点判定、能力の持続時間を更新する
+void server_simulation_step(ServerContext *ctx, float dt);
+
@@ -0,0 +1,158 @@
+#include "server_matchmaking.h"
+#include <cstring>
+#include "log.h"
+#include "server_session.h"
+#include "../server_constants.h"
+
+void matchmaking_enqueue_client(ServerContext *ctx, TCPsocket socket)
+{
+    if (!matchmaking_enqueue(&ctx->matchmaking, socket, SDL_GetTicks()))
+    {
+        LOG_WARN("マッチング待機列が満杯");
+        SDLNet_TCP_Close(socket);
+        return;
+    }
+
+    event_loop_add_client(&ctx->loop, socket);
+    LOG_INFO("マッチング待機 (待機人数 " << ctx->matchmaking.count << ")");
+}
+
+static void matchmaking_drop_client(ServerContext *ctx, int index)
+{
+    TCPsocket socket = ctx->matchmaking.entries[index].socket;
+    matchmaking_remove(&ctx->matchmaking, index);
+    event_loop_remove(&ctx->loop, socket);
+    SDLNet_TCP_Close(socket);
+}
+
+// 待機順リスト1本分の接続を確認する
+static void poll_list(ServerContext *ctx, int index)
+{
+    MatchmakingQueue *queue = &ctx->matchmaking;
+
+    while (index != MATCHMAKING_NONE)
+    {
+        int next = queue->entries[index].age_next;
+        TCPsocket socket = queue->entries[index].socket;
+
+        if (SDLNet_SocketReady(socket))
+        {
+            Packet packet;
+            int size = network_receive_packet(socket, &packet);
+
+            if (size <= 0)
+            {
+                LOG_INFO("マッチング待機中に切断");
+                matchmaking_drop_client(ctx, index);
+            }
+            else if (packet.type == PACKET_TYPE_MATCHMAKING_JOIN && packet.size == sizeof(MatchmakingJoin))
+            {
+                MatchmakingJoin join;
+                memcpy(&join, packet.data, sizeof(MatchmakingJoin));
+                matchmaking_set_rating(queue, index, join.rating);
+            }
+            else if (packet.type == PACKET_TYPE_SESSION_RESUME && packet.size == sizeof(SessionToken))
+            {
+                // ホットリスタート前の試合への再接続は、再接続待ちのない新プロセスでは待機列に入ってくる
+                SessionToken request;
+                memcpy(&request, packet.data, sizeof(SessionToken));
+                if (session_route_resume(ctx, socket, &request))
+                    matchmaking_remove(queue, index);
+                else
+                    matchmaking_drop_client(ctx, index);
+            }
+        }
+        index = next;
+    }
+}
+
+void matchmaking_poll_clients(ServerContext *ctx)
+{
+    // 確定済みを先に見る（未確定から確定した接続は確定済みの末尾へ移るので二重には見ない）
+    int unrated_head = ctx->matchmaking.unrated_head;
+    poll_list(ctx, ctx->matchmaking.age_head);
+    poll_list(ctx, unrated_head);
+}
+
+// MATCHMAKING_JOIN を送ってこないまま期限を過ぎた接続はデフォルトのレーティングで確定する
+static void rate_timed_out_clients(ServerContext *ctx, Uint32 now_ms)
+{
+    MatchmakingQueue *queue = &ctx->matchmaking;
+
+    // 未確定の列は接続順なので、期限前のものが出てきたら終わり
+    int index = matchmaking_oldest_unrated(queue);
+    while (index != MATCHMAKING_NONE && (int)(now_ms - queue->entries[index].enqueued_ms) >= MATCHMAKING_JOIN_TIMEOUT_MS)
+    {
+        matchmaking_set_rating(queue, index, MATCHMAKING_DEFAULT_RATING);
+        index = matchmaking_oldest_unrated(queue);
+    }
+}
+
+uint64_t matchmaking_wake_deadline(const ServerContext *ctx, uint64_t now_ns)
+{
+    const MatchmakingQueue *queue = &ctx->matchmaking;
+    if (queue->count == 0)
+        return EVENT_LOOP_NO_DEADLINE;
+
+    // 確定済みの待機者は許容範囲を広げるために定期的に見直す
+    uint64_t deadline = now_ns + (uint64_t)MATCHMAKING_WIDEN_INTERVAL_MS * 1000000ULL;
+
+    int oldest = matchmaking_oldest_unrated(queue);
+    if (oldest != MATCHMAKING_NONE)
+    {
+        int waited_ms = (int)(SDL_GetTicks() - queue->entries[oldest].enqueued_ms);
+        int remaining_ms = (waited_ms >= MATCHMAKING_JOIN_TIMEOUT_MS) ? 0 : MATCHMAKING_JOIN_TIMEOUT_MS - waited_ms;
+        uint64_t timeout = now_ns + (uint64_t)remaining_ms * 1000000ULL;
+        if (timeout < deadline)
+            deadline = timeout;
+    }
+    return deadline;
+}
+
+// 待機列から取り出した接続をプレイヤースロットへ割り当てる
+static bool matchmaking_assign(ServerContext *ctx, TCPsocket socket)
+{
+    if (network_assign_client(socket, ctx->players, ctx->connections, server_config_match_players(&ctx->config)) >= 0)
+        return true;
+
+    event_loop_remove(&ctx->loop, socket);
+    SDLNet_TCP_Close(socket);
+    return false;
+}
+
+int matchmaking_fill_slots(ServerContext *ctx)
+{
+    Uint32 now_ms = SDL_GetTicks();
+    rate_timed_out_clients(ctx, now_ms);
+
+    int free_slots = server_config_match_players(&ctx->config) - count_connected_clients(ctx->players);
+    int filled = 0;
+
+    while (free_slots >= 2)
+    {
+        TCPsocket first, second;
+        if (!matchmaking_find_pair(&ctx->matchmaking, now_ms, &first, &second))
+            break;
+
+        filled += matchmaking_assign(ctx, first) ? 1 : 0;
+        filled += matchmaking_assign(ctx, second) ? 1 : 0;
+        free_slots -= 2;
+    }
+
+    // 1人分だけ空いている場合は最も長く待っている人を入れる
+    if (free_slots == 1)
+    {
+        TCPsocket socket = matchmaking_pop_oldest(&ctx->matchmaking);
+        if (socket && matchmaking_assign(ctx, socket))
+            filled++;
+    }
+    return filled;
+}
+
+void matchmaking_shutdown(ServerContext *ctx)
+{
+    while (ctx->matchmaking.age_head != MATCHMAKING_NONE)
+        matchmaking_drop_client(ctx, ctx->matchmaking.age_head);
+    while (ctx->matchmaking.unrated_head != MATCHMAKING_NONE)
+        matchmaking_drop_client(ctx, ctx->matchmaking.unrated_head);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "server_context.h"
+
+// 新規接続をレーティング未確定としてマッチング待機列へ入れる
+void matchmaking_enqueue_client(ServerContext *ctx, TCPsocket socket);
+
+// 待機中の接続からのレーティング通知・切断を処理
+void matchmaking_poll_clients(ServerContext *ctx);
+
+// 次に待機列を見直すべき時刻（待機者がいなければ EVENT_LOOP_NO_DEADLINE）
+uint64_t matchmaking_wake_deadline(const ServerContext *ctx, uint64_t now_ns);
+
+// 空いているプレイヤースロットを待機列から埋める
+// 期限を過ぎた未確定の接続をデフォルトのレーティングで確定してから、確定済みの中で組ませる
+// 両スロットが空いていればレーティングの近い2人を組ませる
+// 戻り値: 埋めたスロット数
+int matchmaking_fill_slots(ServerContext *ctx);
+
+// 待機列の全接続を閉じる
+void matchmaking_shutdown(ServerContext *ctx);
@@ -0,0 +1,255 @@
+#include "server_session.h"
+#include <cstring>
+#include <random>
+#include "log.h"
+#include "server_broadcast.h"
+#include "../server_constants.h"
+
+static uint64_t session_generate_token()
+{
+    static std::mt19937_64 engine(std::random_device{}());
+    uint64_t token = 0;
+    while (token == 0)
+        token = engine();
+    return token;
+}
+
+void session_issue_token(ServerContext *ctx, int player_id)
+{
+    ClientConnection *connection = &ctx->connections[player_id];
+    if (!connection->socket)
+        return;
+
+    connection->session_token = session_generate_token();
+    Packet packet = create_packet_session_token(player_id, connection->session_token);
+    network_send_packet_to(connection, &packet);
+}
+
+void session_suspend_client(ServerContext *ctx, int player_id)
+{
+    ClientConnection *connection = &ctx->connections[player_id];
+
+    if (connection->session_token == 0)
+    {
+        network_close_client(&ctx->players[player_id], connection);
+        return;
+    }
+
+    // スロット（players[].connected）は保持したままソケットだけ閉じる
+    if (connection->socket)
+    {
+        SDLNet_TCP_Close(connection->socket);
+        connection->socket = nullptr;
+    }
+    connection->suspended = true;
+    connection->suspended_at_ms = SDL_GetTicks();
+    LOG_WARN("クライアント " << player_id << " 再接続待ち（試合を一時停止）");
+}
+
+bool session_match_paused(const ServerContext *ctx)
+{
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (ctx->connections[i].suspended)
+            return true;
+    }
+    return false;
+}
+
+void session_add_pending(ServerContext *ctx, TCPsocket client)
+{
+    for (int i = 0; i < MAX_PENDING_RESUMES; i++)
+    {
+        if (!ctx->pending_sockets[i])
+        {
+            ctx->pending_sockets[i] = client;
+            ctx->pending_since_ms[i] = SDL_GetTicks();
+            event_loop_add_client(&ctx->loop, client);
+            return;
+        }
+    }
+
+    LOG_WARN("再接続待ちが満員");
+    SDLNet_TCP_Close(client);
+}
+
+static void session_drop_pending(ServerContext *ctx, int index)
+{
+    event_loop_remove(&ctx->loop, ctx->pending_sockets[index]);
+    SDLNet_TCP_Close(ctx->pending_sockets[index]);
+    ctx->pending_sockets[index] = nullptr;
+}
+
+// 再接続要求を検証し、一致する保持スロットへソケットを戻す
+static bool session_try_resume(ServerContext *ctx, TCPsocket socket, const SessionToken *request)
+{
+    int id = request->player_id;
+    if (id < 0 || id >= MAX_CLIENTS)
+        return false;
+
+    ClientConnection *connection = &ctx->connections[id];
+    if (!connection->suspended || connection->session_token != request->token)
+        return false;
+
+    // 旧ソケットへの送り残しは捨て、受信制限・入力検査・送信間隔・接続品質も新しい接続として測り直す
+    // （通し番号はクライアントが接続ごとに振り直すので、0から受け付ける）
+    Uint32 now_ms = SDL_GetTicks();
+    connection->socket = socket;
+    connection->suspended = false;
+    network_clear_send_tail(connection);
+    rate_limiter_init(&connection->input_limiter, CLIENT_PACKET_RATE_PER_SEC, CLIENT_PACKET_BURST, now_ms);
+    input_validator_init(&connection->input_validator, now_ms);
+    connection->input_deferred = false;
+    connection->last_input_sequence = 0;
+    link_quality_init(&connection->link_quality);
+    snapshot_pacer_init(&connection->snapshot_pacer);
+
+    // ハンドシェイクは行わず、ID・新トークン・現在の状態一式だけを送る
+    Packet id_packet = create_packet_player_id(id);
+    network_send_packet(socket, &id_packet);
+    session_issue_token(ctx, id);
+    send_full_snapshot(ctx, socket);
+
+    LOG_SUCCESS("クライアント " << id << " 再接続");
+    return true;
+}
+
+bool session_route_resume(ServerContext *ctx, TCPsocket socket, const SessionToken *request)
+{
+    if (session_try_resume(ctx, socket, request))
+        return true;
+    if (!ctx->resume_forward)
+        return false;
+
+    // 旧プロセスが終了していれば送れないので、以降は転送しない
+    if (!network_send_fd(ctx->resume_forward, network_get_socket_fd(socket), request, sizeof(SessionToken)))
+    {
+        LOG_INFO("旧プロセスへの再接続の転送を終了");
+        SDLNet_TCP_Close(ctx->resume_forward);
+        ctx->resume_forward = nullptr;
+        return false;
+    }
+
+    // ディスクリプタは複製されて旧プロセスへ渡ったので、こちらの分は閉じる
+    event_loop_remove(&ctx->loop, socket);
+    SDLNet_TCP_Close(socket);
+    LOG_INFO("プレイヤー " << request->player_id << " の再接続を旧プロセスへ転送");
+    return true;
+}
+
+// 新プロセスから転送されてきた再接続を受け取る（ドレイン中の旧プロセス）
+static void session_receive_forwarded(ServerContext *ctx)
+{
+    if (!ctx->resume_inbox || !SDLNet_SocketReady(ctx->resume_inbox))
+        return;
+
+    TCPsocket socket;
+    SessionToken request;
+    int result;
+    while ((result = network_receive_fd(ctx->resume_inbox, &socket, &request, sizeof(SessionToken))) > 0)
+    {
+        event_loop_add_client(&ctx->loop, socket);
+        if (!session_route_resume(ctx, socket, &request))
+        {
+            LOG_WARN("不正な再接続要求（新プロセスから転送）");
+            event_loop_remove(&ctx->loop, socket);
+            SDLNet_TCP_Close(socket);
+        }
+    }
+
+    if (result < 0)
+    {
+        LOG_INFO("新プロセスからの再接続の転送経路が閉じました");
+        event_loop_remove(&ctx->loop, ctx->resume_inbox);
+        SDLNet_TCP_Close(ctx->resume_inbox);
+        ctx->resume_inbox = nullptr;
+    }
+}
+
+void session_update(ServerContext *ctx)
+{
+    Uint32 now = SDL_GetTicks();
+
+    session_receive_forwarded(ctx);
+
+    for (int i = 0; i < MAX_PENDING_RESUMES; i++)
+    {
+        TCPsocket socket = ctx->pending_sockets[i];
+        if (!socket)
+            continue;
+
+        // 1パケット分そろうまでは待たずに次へ（猶予内に残りが届けばまた通知される）
+        Packet packet;
+        NetworkTryReceiveResult received =
+            SDLNet_SocketReady(socket) ? network_try_receive_packet(socket, &packet) : NETWORK_RECEIVE_PENDING;
+        if (received != NETWORK_RECEIVE_PENDING)
+        {
+            bool resumed = false;
+
+            if (received == NETWORK_RECEIVE_OK && packet.type == PACKET_TYPE_SESSION_RESUME &&
+                packet.size == sizeof(SessionToken))
+            {
+                SessionToken request;
+                memcpy(&request, packet.data, sizeof(SessionToken));
+                resumed = session_route_resume(ctx, socket, &request);
+            }
+
+            if (resumed)
+            {
+                // ソケットはイベントループに登録済みのままプレイヤー側へ移る（転送した場合は閉じ済み）
+                ctx->pending_sockets[i] = nullptr;
+            }
+            else
+            {
+                LOG_WARN("不正な再接続要求");
+                session_drop_pending(ctx, i);
+            }
+            continue;
+        }
+
+        if ((int)(now - ctx->pending_since_ms[i]) > RECONNECT_GRACE_MS)
+            session_drop_pending(ctx, i);
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        ClientConnection *connection = &ctx->connections[i];
+        if (connection->suspended && (int)(now - connection->suspended_at_ms) > RECONNECT_GRACE_MS)
+        {
+            LOG_WARN("クライアント " << i << " 再接続猶予切れ");
+            connection->suspended = false;
+            connection->session_token = 0;
+            network_close_client(&ctx->players[i], connection);
+        }
+    }
+}
+
+void session_close_resume_channels(ServerContext *ctx)
+{
+    if (ctx->resume_inbox)
+    {
+        event_loop_remove(&ctx->loop, ctx->resume_inbox);
+        SDLNet_TCP_Close(ctx->resume_inbox);
+        ctx->resume_inbox = nullptr;
+    }
+    if (ctx->resume_forward)
+    {
+        SDLNet_TCP_Close(ctx->resume_forward);
+        ctx->resume_forward = nullptr;
+    }
+}
+
+void session_reset(ServerContext *ctx)
+{
+    for (int i = 0; i < MAX_PENDING_RESUMES; i++)
+    {
+        if (ctx->pending_sockets[i])
+            session_drop_pending(ctx, i);
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        ctx->connections[i].suspended = false;
+        ctx->connections[i].session_token = 0;
+    }
+}
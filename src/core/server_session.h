@@ -0,0 +1,31 @@
+#pragma once
+
+#include "server_context.h"
+
+// セッショントークンを発行してクライアントへ送信
+// PACKET_TYPE_SET_PLAYER_ID の直後に呼ぶ
+void session_issue_token(ServerContext *ctx, int player_id);
+
+// 切断したクライアントのスロットを猶予期間つきで保持する
+// トークン未発行のクライアントは従来どおり切断する
+void session_suspend_client(ServerContext *ctx, int player_id);
+
+// 猶予期間中のクライアントがいるか（いる間は試合を一時停止する）
+bool session_match_paused(const ServerContext *ctx);
+
+// 受け付けた接続を再接続要求待ちにする（満員なら閉じる）
+void session_add_pending(ServerContext *ctx, TCPsocket client);
+
+// 再接続要求の処理と猶予期間切れの処理（新プロセスから転送された再接続も受け取る）
+void session_update(ServerContext *ctx);
+
+// 再接続要求を自プロセスの試合に戻すか、ホットリスタート前のプロセスへ転送する
+// socketはイベントループに登録済みのもの
+// 戻り値: ソケットを引き取った（戻した・転送して閉じた）場合true、falseなら呼び出し側が閉じる
+bool session_route_resume(ServerContext *ctx, TCPsocket socket, const SessionToken *request);
+
+// 転送経路を閉じる
+void session_close_resume_channels(ServerContext *ctx);
+
+// 再接続待ちの状態をすべて破棄する
+void session_reset(ServerContext *ctx);
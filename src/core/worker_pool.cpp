@@ -0,0 +1,499 @@
+#include "worker_pool.h"
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "log.h"
+
+WorkerRegistry *worker_registry_create(int worker_count)
+{
+    // fork後も全プロセスから同じ内容が見えるよう匿名共有メモリに置く
+    void *memory = mmap(nullptr, sizeof(WorkerRegistry), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        LOG_ERROR("ワーカー一覧の確保失敗: " << strerror(errno));
+        return nullptr;
+    }
+
+    WorkerRegistry *registry = (WorkerRegistry *)memory;
+    memset(registry, 0, sizeof(WorkerRegistry));
+    registry->worker_count = worker_count;
+    for (int i = 0; i < MAX_WORKERS; i++)
+        registry->workers[i].cpu = -1;
+    return registry;
+}
+
+// 呼び出し元のプロセスを1つのコアに固定する
+// 戻り値: 固定したコア番号（失敗時-1）
+static int pin_to_cpu(int cpu)
+{
+    if (cpu < 0)
+        return -1;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0)
+        return -1;
+    return cpu;
+}
+
+// 受付プロセスのリスナーと、各ワーカーへの経路（受付プロセス側の端）
+static TCPsocket s_player_listener = nullptr;
+static TCPsocket s_spectator_listener = nullptr;
+static TCPsocket s_channels[MAX_WORKERS];
+static sigset_t s_saved_mask;
+
+int worker_pool_spawn(WorkerRegistry *registry, int port, int spectator_port, int *channel_fd)
+{
+    const long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    const pid_t supervisor = getpid();
+
+    // fork前に止めておき、受付プロセスは signalfd で受ける（起動直後のシグナルを既定動作で受けて落ちないように）
+    sigset_t blocked;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    sigaddset(&blocked, SIGUSR2);
+    sigaddset(&blocked, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &blocked, &s_saved_mask);
+
+    // 入れ替え用の新サーバーが同じポートで起動できるよう SO_REUSEPORT で開く
+    s_player_listener = network_open_reuseport_listener(port);
+    if (spectator_port > 0 && s_player_listener)
+    {
+        s_spectator_listener = network_open_reuseport_listener(spectator_port);
+        if (!s_spectator_listener)
+        {
+            SDLNet_TCP_Close(s_player_listener);
+            s_player_listener = nullptr;
+        }
+    }
+    if (!s_player_listener)
+    {
+        sigprocmask(SIG_SETMASK, &s_saved_mask, nullptr);
+        return WORKER_SPAWN_FAILED;
+    }
+
+    for (int i = 0; i < registry->worker_count; i++)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0)
+        {
+            LOG_ERROR("ワーカー " << i << " への経路の作成失敗: " << strerror(errno));
+            break;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            LOG_ERROR("ワーカー " << i << " の起動失敗: " << strerror(errno));
+            close(fds[0]);
+            close(fds[1]);
+            break;
+        }
+
+        if (pid == 0)
+        {
+            // 親が先に落ちた場合は試合を終えてから終了する
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (getppid() != supervisor)
+                _exit(1);
+
+            // リスナーと他のワーカーへの経路は受付プロセスだけが持つ
+            SDLNet_TCP_Close(s_player_listener);
+            if (s_spectator_listener)
+                SDLNet_TCP_Close(s_spectator_listener);
+            for (int j = 0; j < i; j++)
+            {
+                if (s_channels[j])
+                    SDLNet_TCP_Close(s_channels[j]);
+            }
+            close(fds[0]);
+            *channel_fd = fds[1];
+
+            WorkerStatus *status = &registry->workers[i];
+            status->pid = getpid();
+            status->cpu = pin_to_cpu(cpu_count > 0 ? (int)(i % cpu_count) : -1);
+
+            // 呼び出し元が設定したハンドラーで受けるよう元に戻す（止めている間に届いた分はここで配られる）
+            sigprocmask(SIG_SETMASK, &s_saved_mask, nullptr);
+            return i;
+        }
+
+        close(fds[1]);
+        s_channels[i] = network_wrap_fd_channel(fds[0]);
+        registry->workers[i].pid = pid;
+    }
+    return WORKER_SUPERVISOR;
+}
+
+// 振り分け待ちの接続（最初のパケットが届くまで、再接続要求かどうか判断できない）
+struct PendingConnection
+{
+    int fd;
+    Uint32 deadline_ms;
+};
+
+static bool worker_routable(const WorkerRegistry *registry, int index)
+{
+    return registry->workers[index].pid > 0 && s_channels[index] != nullptr;
+}
+
+// 再接続要求のトークンを発行したワーカー（なければ-1）
+static int find_session_owner(const WorkerRegistry *registry, const SessionToken *request)
+{
+    if (request->token == 0 || request->player_id < 0 || request->player_id >= MAX_CLIENTS)
+        return -1;
+    for (int i = 0; i < registry->worker_count; i++)
+    {
+        if (worker_routable(registry, i) && registry->workers[i].session_tokens[request->player_id] == request->token)
+            return i;
+    }
+    return -1;
+}
+
+// 新規のプレイヤー: 試合をしていないワーカーのうち待機人数が最も多いもの（早く試合が始まる）
+// なければ待機人数が最も少ないもの
+static int pick_player_worker(const WorkerRegistry *registry)
+{
+    int idle_best = -1;
+    int busy_best = -1;
+    for (int i = 0; i < registry->worker_count; i++)
+    {
+        if (!worker_routable(registry, i))
+            continue;
+        const WorkerStatus *status = &registry->workers[i];
+        if (!status->in_match)
+        {
+            if (idle_best < 0 || status->queued > registry->workers[idle_best].queued)
+                idle_best = i;
+        }
+        else if (busy_best < 0 || status->queued < registry->workers[busy_best].queued)
+        {
+            busy_best = i;
+        }
+    }
+    return idle_best >= 0 ? idle_best : busy_best;
+}
+
+// 観戦者: 試合中のワーカーへ順番に（どこも試合をしていなければ最初のワーカー）
+static int pick_spectator_worker(const WorkerRegistry *registry)
+{
+    static int next = 0;
+    int fallback = -1;
+    for (int n = 0; n < registry->worker_count; n++)
+    {
+        int i = (next + n) % registry->worker_count;
+        if (!worker_routable(registry, i))
+            continue;
+        if (registry->workers[i].in_match)
+        {
+            next = i + 1;
+            return i;
+        }
+        if (fallback < 0)
+            fallback = i;
+    }
+    return fallback;
+}
+
+static void close_worker_channel(int index)
+{
+    if (!s_channels[index])
+        return;
+    SDLNet_TCP_Close(s_channels[index]);
+    s_channels[index] = nullptr;
+}
+
+// 接続をワーカーへ渡して、こちらのディスクリプタを閉じる
+// owner が -1 なら kind に応じて選ぶ。渡せなかったワーカーは経路を閉じて選び直す
+static void hand_off(WorkerRegistry *registry, int fd, int kind, int owner)
+{
+    WorkerHandoff handoff;
+    handoff.kind = kind;
+    for (int attempt = 0; attempt < registry->worker_count; attempt++)
+    {
+        int worker = owner >= 0 ? owner
+                   : (kind == WORKER_HANDOFF_SPECTATOR ? pick_spectator_worker(registry) : pick_player_worker(registry));
+        owner = -1;
+        if (worker < 0)
+            break;
+        if (network_send_fd(s_channels[worker], fd, &handoff, sizeof(handoff)))
+            break;
+        LOG_WARN("ワーカー " << worker << " へ接続を渡せません: 振り分け対象から外します");
+        close_worker_channel(worker);
+    }
+    close(fd);
+}
+
+// 最初のパケットを覗いて振り分け先を決める
+// 戻り値: 渡したか閉じたならtrue（まだ判断できなければfalse）
+static bool route_pending(WorkerRegistry *registry, const PendingConnection *pending, Uint32 now_ms)
+{
+    Packet packet;
+    ssize_t received = recv(pending->fd, &packet, sizeof(Packet), MSG_PEEK);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+    {
+        close(pending->fd);
+        return true;
+    }
+
+    if (received == (ssize_t)sizeof(Packet))
+    {
+        // ヘッダーは検査前なので、型は整数として取り出してから比べる
+        int owner = -1;
+        if (network_packet_raw_type(&packet) == PACKET_TYPE_SESSION_RESUME && packet.size == sizeof(SessionToken))
+        {
+            SessionToken request;
+            memcpy(&request, packet.data, sizeof(SessionToken));
+            owner = find_session_owner(registry, &request);
+        }
+        hand_off(registry, pending->fd, WORKER_HANDOFF_PLAYER, owner);
+        return true;
+    }
+
+    // 何も送ってこない接続は新規のプレイヤーとして扱う
+    if ((int32_t)(now_ms - pending->deadline_ms) >= 0)
+    {
+        hand_off(registry, pending->fd, WORKER_HANDOFF_PLAYER, -1);
+        return true;
+    }
+    return false;
+}
+
+// 終了したワーカーを回収する
+// 戻り値: 回収した数
+static int reap_workers(WorkerRegistry *registry, int *exit_code)
+{
+    int reaped = 0;
+    int status = 0;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        for (int i = 0; i < registry->worker_count; i++)
+        {
+            if (registry->workers[i].pid != pid)
+                continue;
+
+            registry->workers[i].pid = 0;
+            close_worker_channel(i);
+            reaped++;
+
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+            {
+                LOG_INFO("ワーカー " << i << " 終了 (試合数 " << registry->workers[i].matches_finished << ")");
+            }
+            else
+            {
+                LOG_WARN("ワーカー " << i << " 異常終了 (status " << status << ")");
+                *exit_code = 1;
+            }
+            break;
+        }
+    }
+    return reaped;
+}
+
+static bool handle_signal(WorkerRegistry *registry, int signal_fd, int *alive, int *exit_code)
+{
+    struct signalfd_siginfo info;
+    while (read(signal_fd, &info, sizeof(info)) == (ssize_t)sizeof(info))
+    {
+        int signum = (int)info.ssi_signo;
+        if (signum == SIGCHLD)
+        {
+            *alive -= reap_workers(registry, exit_code);
+        }
+        else if (signum == SIGUSR2)
+        {
+            LOG_ERROR("ワーカーモードではホットリスタート非対応: 新しいサーバーを同じポートで起動してから旧サーバーへSIGTERMを送ってください");
+        }
+        else
+        {
+            for (int i = 0; i < registry->worker_count; i++)
+            {
+                pid_t pid = registry->workers[i].pid;
+                if (pid > 0)
+                    kill(pid, signum);
+            }
+        }
+    }
+    return *alive > 0;
+}
+
+// 受け付けた接続の数だけ振り分け待ちに積む（観戦者はすぐ渡す）
+static void accept_connections(WorkerRegistry *registry, int epoll_fd, TCPsocket listener, int kind,
+                               PendingConnection *pending, int *pending_count)
+{
+    int listen_fd = network_get_socket_fd(listener);
+    int fd;
+    while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+    {
+        if (kind == WORKER_HANDOFF_SPECTATOR)
+        {
+            hand_off(registry, fd, kind, -1);
+            continue;
+        }
+        if (*pending_count >= WORKER_ROUTE_MAX_PENDING)
+        {
+            hand_off(registry, fd, kind, -1);
+            continue;
+        }
+
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            hand_off(registry, fd, kind, -1);
+            continue;
+        }
+        pending[*pending_count].fd = fd;
+        pending[*pending_count].deadline_ms = SDL_GetTicks() + WORKER_ROUTE_WAIT_MS;
+        (*pending_count)++;
+    }
+}
+
+static bool add_to_epoll(int epoll_fd, int fd)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+int worker_pool_supervise(WorkerRegistry *registry)
+{
+    int alive = 0;
+    for (int i = 0; i < registry->worker_count; i++)
+    {
+        if (registry->workers[i].pid > 0)
+            alive++;
+    }
+    if (alive == 0)
+        return 1;
+
+    LOG_SUCCESS("ワーカー " << alive << " 個を起動");
+
+    // シグナルは worker_pool_spawn で止めてあるので、ここから signalfd で受ける
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR2);
+    sigaddset(&signals, SIGCHLD);
+    int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    const int player_fd = network_get_socket_fd(s_player_listener);
+    const int spectator_fd = s_spectator_listener ? network_get_socket_fd(s_spectator_listener) : -1;
+    if (signal_fd < 0 || epoll_fd < 0 || !add_to_epoll(epoll_fd, signal_fd) || !add_to_epoll(epoll_fd, player_fd)
+        || (spectator_fd >= 0 && !add_to_epoll(epoll_fd, spectator_fd)))
+    {
+        LOG_ERROR("受付プロセスの初期化失敗: " << strerror(errno));
+        for (int i = 0; i < registry->worker_count; i++)
+        {
+            if (registry->workers[i].pid > 0)
+                kill(registry->workers[i].pid, SIGINT);
+        }
+        return 1;
+    }
+
+    static PendingConnection pending[WORKER_ROUTE_MAX_PENDING];
+    int pending_count = 0;
+    int exit_code = 0;
+
+    // 起動直後に終了したワーカーを回収する（SIGCHLDは止めている間に1つにまとまる）
+    alive -= reap_workers(registry, &exit_code);
+
+    while (alive > 0)
+    {
+        Uint32 now_ms = SDL_GetTicks();
+        int timeout_ms = -1;
+        for (int i = 0; i < pending_count; i++)
+        {
+            int32_t remaining = (int32_t)(pending[i].deadline_ms - now_ms);
+            if (remaining < 0)
+                remaining = 0;
+            if (timeout_ms < 0 || remaining < timeout_ms)
+                timeout_ms = remaining;
+        }
+
+        struct epoll_event events[16];
+        int count = epoll_wait(epoll_fd, events, 16, timeout_ms);
+        if (count < 0 && errno != EINTR)
+        {
+            LOG_ERROR("epoll_wait失敗: " << strerror(errno));
+            break;
+        }
+
+        for (int n = 0; n < count; n++)
+        {
+            int fd = events[n].data.fd;
+            if (fd == signal_fd)
+                handle_signal(registry, signal_fd, &alive, &exit_code);
+            else if (fd == player_fd)
+                accept_connections(registry, epoll_fd, s_player_listener, WORKER_HANDOFF_PLAYER, pending, &pending_count);
+            else if (fd == spectator_fd)
+                accept_connections(registry, epoll_fd, s_spectator_listener, WORKER_HANDOFF_SPECTATOR, pending, &pending_count);
+        }
+
+        // 最初のパケットが届いたか待ち時間を過ぎた接続を振り分ける（閉じたディスクリプタはepollからも外れる）
+        now_ms = SDL_GetTicks();
+        int kept = 0;
+        for (int i = 0; i < pending_count; i++)
+        {
+            if (!route_pending(registry, &pending[i], now_ms))
+                pending[kept++] = pending[i];
+        }
+        pending_count = kept;
+    }
+
+    for (int i = 0; i < pending_count; i++)
+        close(pending[i].fd);
+    for (int i = 0; i < registry->worker_count; i++)
+        close_worker_channel(i);
+    SDLNet_TCP_Close(s_player_listener);
+    if (s_spectator_listener)
+        SDLNet_TCP_Close(s_spectator_listener);
+    close(epoll_fd);
+    close(signal_fd);
+    return exit_code;
+}
+
+void worker_status_match_started(WorkerStatus *status, int players)
+{
+    if (!status)
+        return;
+    status->match_id = status->match_id + 1;
+    status->players = players;
+    status->in_match = 1;
+}
+
+void worker_status_match_finished(WorkerStatus *status)
+{
+    if (!status)
+        return;
+    status->in_match = 0;
+    status->players = 0;
+    status->matches_finished = status->matches_finished + 1;
+}
+
+void worker_status_publish(WorkerStatus *status, int queued, const uint64_t session_tokens[MAX_CLIENTS])
+{
+    if (!status)
+        return;
+    status->queued = queued;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+        status->session_tokens[i] = session_tokens[i];
+}
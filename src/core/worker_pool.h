@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "network/network.h"
+#include "../server_constants.h"
+
+// worker_pool_spawn の戻り値（親プロセス側）
+#define WORKER_SUPERVISOR (-1)
+#define WORKER_SPAWN_FAILED (-2)
+
+// ワーカー1つ分の状態（各ワーカーは自分のスロットだけを書き込み、他は読むだけ）
+struct WorkerStatus
+{
+    volatile pid_t pid;                // 0: 未起動・終了済み
+    volatile int cpu;                  // 固定したコア（-1: 固定なし）
+    volatile int in_match;             // 試合中なら1
+    volatile uint32_t match_id;        // 現在（直近）の試合番号（ワーカー内の連番）
+    volatile int players;              // 試合中の接続プレイヤー数
+    volatile uint32_t matches_finished;
+
+    // 受付プロセスが振り分けに使う
+    volatile int queued;                             // マッチング待機列の人数
+    volatile uint64_t session_tokens[MAX_CLIENTS];  // 発行済みのセッショントークン（0: なし、再接続をこのワーカーへ送る）
+};
+
+// プロセス間で共有するワーカー一覧（fork前に共有メモリへ確保する）
+struct WorkerRegistry
+{
+    int worker_count;
+    WorkerStatus workers[MAX_WORKERS];
+};
+
+// 受付プロセスからワーカーへ渡す接続の種類
+enum WorkerHandoffKind
+{
+    WORKER_HANDOFF_PLAYER,
+    WORKER_HANDOFF_SPECTATOR,
+};
+
+// 接続のディスクリプタと一緒に送るデータ
+struct WorkerHandoff
+{
+    int kind;  // WorkerHandoffKind
+};
+
+// 共有メモリ上にワーカー一覧を確保（失敗時NULL）
+WorkerRegistry *worker_registry_create(int worker_count);
+
+// 受付プロセスのリスナーを開き、ワーカーを起動してそれぞれ別のコアに固定する
+// SIGINT・SIGTERM・SIGUSR2・SIGCHLD はfork前に止めておき、ワーカーでは呼び出し元が設定したハンドラーへ戻す
+// （親はシグナルを signalfd で受けるので、起動直後に届いたシグナルも取りこぼさない）
+// channel_fd: 子プロセスでは受付プロセスから接続を受け取る経路のディスクリプタ
+// 戻り値: 子プロセスでは自分の番号（0〜）、親プロセスでは WORKER_SUPERVISOR、リスナーを開けなければ WORKER_SPAWN_FAILED
+int worker_pool_spawn(WorkerRegistry *registry, int port, int spectator_port, int *channel_fd);
+
+// 親プロセス（受付プロセス）: 接続を受け付けてワーカーへ振り分けながら、全ワーカーの終了を待つ
+// 再接続要求はそのセッションを持つワーカーへ、新規のプレイヤーは試合をしていないワーカーへ、観戦者は試合中のワーカーへ送る
+// SIGINT・SIGTERMは全ワーカーへ転送する
+// 戻り値: プロセスの終了コード
+int worker_pool_supervise(WorkerRegistry *registry);
+
+// 試合の開始・終了を記録する（statusがNULLなら何もしない）
+void worker_status_match_started(WorkerStatus *status, int players);
+void worker_status_match_finished(WorkerStatus *status);
+
+// 待機人数と発行済みのセッショントークンを受付プロセスへ公開する（statusがNULLなら何もしない）
+void worker_status_publish(WorkerStatus *status, int queued, const uint64_t session_tokens[MAX_CLIENTS]);
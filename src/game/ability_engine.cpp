@@ -0,0 +1,157 @@
+#include "game/ability_engine.h"
+#include "common/ability_config.h"
+#include "../server_constants.h"
+
+// 効果表（先頭は表にない能力に使う既定の効果: 持続時間だけを管理する）
+static const AbilityEffectDescriptor ABILITY_EFFECTS[] = {
+    {ABILITY_NONE, ABILITY_LIFETIME_TIMED, 0, false, 1.0f, 1.0f, 0.0f, 0},
+    {ABILITY_SPEED_UP, ABILITY_LIFETIME_TIMED, 0, true, 1.0f, ABILITY_SPEED_UP_HIT_VELOCITY_Z_SCALE, ABILITY_SPEED_UP_HIT_GRAVITY, 0},
+    {ABILITY_GIANT, ABILITY_LIFETIME_TOGGLE, 0, false, 1.0f, 1.0f, 0.0f, 0},
+    {ABILITY_CLONE, ABILITY_LIFETIME_TOGGLE, 0, true, 1.0f, 1.0f, 0.0f, ABILITY_CLONE_DECOY_BALLS},
+};
+static const int ABILITY_EFFECT_COUNT = (int)(sizeof(ABILITY_EFFECTS) / sizeof(ABILITY_EFFECTS[0]));
+
+// 発動時にだけ引く（tickごとの処理は添字を使う）
+static int find_descriptor(int ability_type)
+{
+    for (int i = 1; i < ABILITY_EFFECT_COUNT; i++)
+    {
+        if (ABILITY_EFFECTS[i].ability_type == ability_type)
+            return i;
+    }
+    return 0;
+}
+
+bool ability_engine_accepts_type(long long raw_type)
+{
+    long long min_type = ABILITY_EFFECTS[0].ability_type;
+    long long max_type = ABILITY_EFFECTS[0].ability_type;
+    for (int i = 1; i < ABILITY_EFFECT_COUNT; i++)
+    {
+        if (ABILITY_EFFECTS[i].ability_type < min_type)
+            min_type = ABILITY_EFFECTS[i].ability_type;
+        if (ABILITY_EFFECTS[i].ability_type > max_type)
+            max_type = ABILITY_EFFECTS[i].ability_type;
+    }
+    return raw_type >= min_type && raw_type <= max_type;
+}
+
+void ability_engine_init(AbilityEngine *engine)
+{
+    engine->count = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+        engine->slot_of_player[i] = -1;
+}
+
+static void ability_engine_set(AbilityEngine *engine, int player_id, int descriptor_index)
+{
+    int slot = engine->slot_of_player[player_id];
+    if (slot < 0)
+    {
+        slot = engine->count++;
+        engine->slot_of_player[player_id] = slot;
+    }
+    engine->active[slot].player_id = player_id;
+    engine->active[slot].descriptor_index = descriptor_index;
+}
+
+// 末尾と入れ替えて詰める
+static void ability_engine_clear(AbilityEngine *engine, AbilityState states[], int player_id)
+{
+    states[player_id].active_ability = ABILITY_NONE;
+    states[player_id].remaining_frames = 0;
+
+    int slot = engine->slot_of_player[player_id];
+    if (slot < 0)
+        return;
+
+    int last = --engine->count;
+    engine->active[slot] = engine->active[last];
+    engine->slot_of_player[engine->active[slot].player_id] = slot;
+    engine->slot_of_player[player_id] = -1;
+}
+
+bool ability_engine_activate(AbilityEngine *engine, AbilityState states[], int player_id, const AbilityActivateRequest *request)
+{
+    if (player_id < 0 || player_id >= MAX_CLIENTS)
+        return false;
+
+    int index = find_descriptor(request->ability_type);
+    const AbilityEffectDescriptor *effect = &ABILITY_EFFECTS[index];
+    AbilityState *state = &states[player_id];
+
+    if (effect->lifetime == ABILITY_LIFETIME_TOGGLE)
+    {
+        state->player_id = player_id;
+        if (request->trigger != TRIGGER_INSTANT)
+        {
+            ability_engine_clear(engine, states, player_id);
+            return true;
+        }
+        ability_engine_set(engine, player_id, index);
+        state->active_ability = request->ability_type;
+        state->remaining_frames = 1;
+        return true;
+    }
+
+    const AbilityConfig *config = ability_get_config(request->ability_type);
+    if (config == nullptr || !config->requires_server)
+        return false;
+
+    ability_engine_set(engine, player_id, index);
+    state->player_id = player_id;
+    state->active_ability = request->ability_type;
+    state->remaining_frames = (effect->duration_frames > 0) ? effect->duration_frames : config->duration_frames;
+    return true;
+}
+
+uint32_t ability_engine_tick(AbilityEngine *engine, AbilityState states[])
+{
+    uint32_t expired = 0;
+
+    // 消すと末尾が詰められるので後ろから見る
+    for (int slot = engine->count - 1; slot >= 0; slot--)
+    {
+        const ActiveAbility *active = &engine->active[slot];
+        if (ABILITY_EFFECTS[active->descriptor_index].lifetime != ABILITY_LIFETIME_TIMED)
+            continue;
+
+        AbilityState *state = &states[active->player_id];
+        if (state->remaining_frames > 0 && --state->remaining_frames == 0)
+        {
+            expired |= 1u << active->player_id;
+            ability_engine_clear(engine, states, active->player_id);
+        }
+    }
+    return expired;
+}
+
+int ability_engine_apply_hit(AbilityEngine *engine, AbilityState states[], int player_id, Ball *ball)
+{
+    int slot = engine->slot_of_player[player_id];
+    if (slot < 0 || states[player_id].remaining_frames <= 0)
+        return 0;
+
+    // 効果のない項目は倍率1・上書きなしなので、種類を問わず同じ式で掛ける
+    const AbilityEffectDescriptor *effect = &ABILITY_EFFECTS[engine->active[slot].descriptor_index];
+    ball->velocity.y *= effect->hit_velocity_scale_y;
+    ball->velocity.z *= effect->hit_velocity_scale_z;
+    if (effect->hit_gravity_override > 0.0f)
+        ball->gravity_multiplier = effect->hit_gravity_override;
+
+    if (effect->consumed_on_hit)
+        ability_engine_clear(engine, states, player_id);
+    return effect->hit_decoy_balls;
+}
+
+bool ability_engine_has_timers(const AbilityEngine *engine, const AbilityState states[])
+{
+    for (int slot = 0; slot < engine->count; slot++)
+    {
+        const ActiveAbility *active = &engine->active[slot];
+        if (ABILITY_EFFECTS[active->descriptor_index].lifetime == ABILITY_LIFETIME_TIMED &&
+            states[active->player_id].remaining_frames > 0)
+            return true;
+    }
+    return false;
+}
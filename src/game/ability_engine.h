@@ -0,0 +1,66 @@
+#ifndef ABILITY_ENGINE_H
+#define ABILITY_ENGINE_H
+
+#include <stdint.h>
+#include "common/ability.h"
+#include "common/ball.h"
+#include "network/network.h"
+
+// 能力の有効期間の扱い
+enum AbilityLifetime
+{
+    ABILITY_LIFETIME_TIMED,   // 持続フレーム数が尽きると切れる
+    ABILITY_LIFETIME_TOGGLE,  // クライアントがオフにするか、consumed_on_hit の打球で使い切るまで続く
+};
+
+// 能力1種類分の効果
+// 表に1行足すだけで能力を増やせる（処理側は能力の種類で分岐しない）
+struct AbilityEffectDescriptor
+{
+    int ability_type;
+    AbilityLifetime lifetime;
+    int duration_frames;         // 0: commonのAbilityConfigの値を使う
+    bool consumed_on_hit;        // 次の打球で効果を使い切る
+    float hit_velocity_scale_y;  // 打球速度への倍率（1: 変化なし）
+    float hit_velocity_scale_z;
+    float hit_gravity_override;  // 打球の重力倍率（0以下: 変更しない）
+    int hit_decoy_balls;         // 打球と同時に出す分身の数
+};
+
+// 発動中の能力1件
+struct ActiveAbility
+{
+    int player_id;
+    int descriptor_index;  // 効果表の添字（プロセスをまたいで復元できるようポインタは持たない）
+};
+
+// 試合ごとの発動中の能力（先頭から詰めて保持し、毎tickこの件数だけを処理する）
+struct AbilityEngine
+{
+    ActiveAbility active[MAX_CLIENTS];
+    int count;
+    int slot_of_player[MAX_CLIENTS];  // activeの添字（-1: 発動なし）
+};
+
+// 初期化（発動中の能力なし）
+void ability_engine_init(AbilityEngine *engine);
+
+// 受信した能力種別の値を列挙型として読んでよいか（表にある種別の最小〜最大の範囲）
+bool ability_engine_accepts_type(long long raw_type);
+
+// クライアントの発動要求を処理する
+// 戻り値: 能力状態が変わった場合true（呼び出し側が状態を送信する）
+bool ability_engine_activate(AbilityEngine *engine, AbilityState states[], int player_id, const AbilityActivateRequest *request);
+
+// 持続時間を1ゲームフレーム進める
+// 戻り値: 能力が切れたプレイヤーのビットマスク（bit i: プレイヤーi）
+uint32_t ability_engine_tick(AbilityEngine *engine, AbilityState states[]);
+
+// 打球にプレイヤーの能力の効果を掛ける（consumed_on_hit の能力はここで切れる）
+// 戻り値: 打球と同時に出す分身の数
+int ability_engine_apply_hit(AbilityEngine *engine, AbilityState states[], int player_id, Ball *ball);
+
+// 持続時間のカウントダウン中の能力があるか
+bool ability_engine_has_timers(const AbilityEngine *engine, const AbilityState states[]);
+
+#endif
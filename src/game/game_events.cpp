@@ -0,0 +1,34 @@
+#include "game_events.h"
+#include <string.h>
+
+// 書いた数・読んだ数が1周しても添字が連続するように
+static_assert((GAME_EVENT_QUEUE_SIZE & (GAME_EVENT_QUEUE_SIZE - 1)) == 0, "GAME_EVENT_QUEUE_SIZE must be a power of two");
+
+void game_events_init(GameEventQueue *queue)
+{
+    memset(queue, 0, sizeof(GameEventQueue));
+}
+
+void game_events_push(GameEventQueue *queue, GameEventType type, int player_id, int value, uint32_t detail)
+{
+    if (queue->head - queue->tail >= GAME_EVENT_QUEUE_SIZE)
+    {
+        queue->dropped++;
+        return;
+    }
+
+    GameEvent *event = &queue->events[queue->head % GAME_EVENT_QUEUE_SIZE];
+    event->type = type;
+    event->player_id = player_id;
+    event->value = value;
+    event->detail = detail;
+    queue->head++;
+}
+
+int game_events_drain(GameEventQueue *queue, GameEvent *out)
+{
+    int count = 0;
+    while (queue->tail != queue->head)
+        out[count++] = queue->events[queue->tail++ % GAME_EVENT_QUEUE_SIZE];
+    return count;
+}
@@ -0,0 +1,43 @@
+#ifndef GAME_EVENTS_H
+#define GAME_EVENTS_H
+
+#include <stdint.h>
+#include "../server_constants.h"
+
+// 試合中に起きた出来事（試合ごとのリングバッファに積み、tickの最後にまとめて配る）
+// 積む側は配列へ書くだけで、送信・ログ・統計などの処理は受け取る側で行う
+typedef enum
+{
+    GAME_EVENT_PHASE_CHANGED,    // value: 新しいフェーズ、detail: 前のフェーズ
+    GAME_EVENT_POINT_SCORED,     // value: 得点したチーム、detail: SCORE_EVENT_* の組み合わせ、player_id: 最後に打ったプレイヤー
+    GAME_EVENT_BALL_HIT,         // player_id: 打ったプレイヤー、value: 打球の種類
+    GAME_EVENT_ABILITY_CHANGED,  // player_id: 能力状態が変わったプレイヤー、value: 発動した能力（切れた場合は-1）
+} GameEventType;
+
+typedef struct
+{
+    GameEventType type;
+    int player_id;    // 関係するプレイヤー（なければ-1）
+    int value;
+    uint32_t detail;
+} GameEvent;
+
+// 単一スレッドで使う（シミュレーションとその後の配信は同じスレッド）
+typedef struct
+{
+    GameEvent events[GAME_EVENT_QUEUE_SIZE];
+    uint32_t head;     // 書いた数（添字は GAME_EVENT_QUEUE_SIZE で割った余り）
+    uint32_t tail;     // 読んだ数
+    uint32_t dropped;  // 満杯で捨てた数（配信側がログに出して0に戻す）
+} GameEventQueue;
+
+void game_events_init(GameEventQueue *queue);
+
+// 積む（満杯なら捨てて数える）
+void game_events_push(GameEventQueue *queue, GameEventType type, int player_id, int value, uint32_t detail);
+
+// 溜まっている分を古い順に out へ移して空にする
+// 戻り値: 移した数（最大 GAME_EVENT_QUEUE_SIZE）
+int game_events_drain(GameEventQueue *queue, GameEvent *out);
+
+#endif
@@ -1,6 +1,5 @@
 #include "game_phase_manager.h"
 #include "score_logic.h"
-#include "../log.h"
 #include "common/game_constants.h"
 #include "../server_constants.h"
 
@@ -13,6 +12,7 @@ void init_phase_manager(GameState *state)
 
 void set_game_phase(GameState *state, GamePhase next_phase)
 {
+    game_events_push(&state->events, GAME_EVENT_PHASE_CHANGED, -1, (int)next_phase, (uint32_t)state->phase);
     state->phase = next_phase;
     state->state_timer = 0.0f;
 }
@@ -27,6 +27,21 @@ bool is_swing_allowed_phase(GamePhase phase)
     return phase == GAME_PHASE_START_GAME || phase == GAME_PHASE_IN_RALLY;
 }
 
+float phase_time_until_transition(const GameState *state)
+{
+    switch (state->phase)
+    {
+        case GAME_PHASE_MATCH_COMPLETE:
+            return TIME_MATCH_COMPLETE - state->state_timer;
+        case GAME_PHASE_POINT_SCORED:
+            return TIME_AFTER_POINT - state->state_timer;
+        case GAME_PHASE_GAME_FINISHED:
+            return 0.0f;
+        default:
+            return -1.0f;
+    }
+}
+
 static void handle_match_complete_phase(GameState *state)
 {
     if (state->state_timer > TIME_MATCH_COMPLETE)
@@ -37,12 +52,11 @@ static void handle_point_scored_phase(GameState *state)
 {
     if (state->state_timer > TIME_AFTER_POINT)
     {
-        state->ball.hit_count = 0;
+        state->balls[PRIMARY_BALL].hit_count = 0;
 
         if (match_finished(&state->score))
         {
             state->match_winner = get_match_winner(&state->score);
-            LOG_SUCCESS("試合終了！勝者: Player " << (state->match_winner + 1));
             set_game_phase(state, GAME_PHASE_GAME_FINISHED);
         }
         else
@@ -18,4 +18,7 @@ bool is_physics_active_phase(GamePhase phase);
 // スイング可能なフェーズかチェック
 bool is_swing_allowed_phase(GamePhase phase);
 
+// 次のタイマー遷移までの秒数（タイマーで遷移しないフェーズは負の値）
+float phase_time_until_transition(const GameState *state);
+
 #endif
\ No newline at end of file
@@ -3,32 +3,125 @@
 #include "physics/ball_physics.h"
 #include "common/game_constants.h"
 #include "game/score_logic.h"
+#include "game/team.h"
 #include <cstring>
+#include <math.h>
+#include "../server_constants.h"
 
-void init_game(GameState *state)
+void init_game(GameState *state, int player_count, const ScoreFormat *format, CourtSurface surface)
 {
-    // Player1: 手前側 (Z > 0)
-    player_init(&state->players[0], "Player1", 0.0f, GameConstants::GROUND_Y, GameConstants::PLAYER_BASELINE_DISTANCE);
-    state->players[0].player_id = 0;
-    state->players[0].connected = false;
+    state->player_count = player_count;
+    state->surface = surface;
+    for (int team = 0; team < TEAM_COUNT; team++)
+        state->team_server_slot[team] = 0;
 
-    // Player2: 奥側 (Z < 0)
-    player_init(&state->players[1], "Player2", 0.0f, GameConstants::GROUND_Y, -GameConstants::PLAYER_BASELINE_DISTANCE);
-    state->players[1].player_id = 1;
-    state->players[1].connected = false;
+    // 偶数ID: 手前側 (Z > 0)、奇数ID: 奥側 (Z < 0)
+    static const char *const PLAYER_NAMES[MAX_CLIENTS] = {"Player1", "Player2", "Player3", "Player4"};
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        float z = team_side(team_of(i)) * GameConstants::PLAYER_BASELINE_DISTANCE;
+        player_init(&state->players[i], PLAYER_NAMES[i], player_home_x(state, i), GameConstants::GROUND_Y, z);
+        state->players[i].player_id = i;
+        state->players[i].connected = false;
+    }
+
+    player_kinematics_init(&state->kinematics);
 
     // ボール初期化
     constexpr float INITIAL_SERVE_Z = GameConstants::PLAYER_BASELINE_DISTANCE - GameConstants::BALL_SERVE_OFFSET_FROM_BASELINE;
-    state->ball.point = (Point3d){0.0f, GameConstants::BALL_SERVE_HEIGHT, INITIAL_SERVE_Z};
-    state->ball.velocity = (Point3d){0.0f, 0.0f, 0.0f};
-    state->ball.angle = 0;
-    state->ball.last_hit_player_id = 0;
-    state->ball.bounce_count = 0;
-    state->ball.hit_count = 0;
-
-    init_score(&state->score);
+    Ball *ball = &state->balls[PRIMARY_BALL];
+    ball->point = (Point3d){0.0f, GameConstants::BALL_SERVE_HEIGHT, INITIAL_SERVE_Z};
+    ball->velocity = (Point3d){0.0f, 0.0f, 0.0f};
+    ball->angle = 0;
+    ball->last_hit_player_id = 0;
+    ball->bounce_count = 0;
+    ball->hit_count = 0;
+    ball->gravity_multiplier = 1.0f;
+    state->ball_roles[PRIMARY_BALL].owner_id = -1;
+    state->ball_roles[PRIMARY_BALL].scoring = BALL_SCORING_POINT;
+    state->ball_count = 1;
+
+    init_score(&state->score, format);
     std::memset(state->ability_states, 0, sizeof(state->ability_states));
+    ability_engine_init(&state->ability_engine);
+    game_events_init(&state->events);
 
     state->match_winner = -1;
     state->match_result_sent = false;
 }
+
+float player_home_x(const GameState *state, int player_id)
+{
+    if (state->player_count <= TEAM_COUNT)
+        return 0.0f;
+
+    float lane_x = GameConstants::COURT_HALF_WIDTH * DOUBLES_LANE_X_RATIO;
+    return (team_slot_of(player_id) == 0) ? -lane_x : lane_x;
+}
+
+uint32_t update_player_kinematics(GameState *state, float dt)
+{
+    const int count = state->player_count;
+    float x[MAX_CLIENTS], z[MAX_CLIENTS], max_speed[MAX_CLIENTS];
+    float min_x[MAX_CLIENTS], max_x[MAX_CLIENTS], min_z[MAX_CLIENTS], max_z[MAX_CLIENTS];
+
+    // 横はサイドラインの外まで、縦はネットから自陣ベースラインの後ろまで
+    const float side_limit = GameConstants::COURT_HALF_WIDTH + PLAYER_AREA_SIDE_MARGIN;
+    const float back_limit = GameConstants::COURT_HALF_LENGTH + PLAYER_AREA_BACK_MARGIN;
+    for (int i = 0; i < count; i++)
+    {
+        const Player *player = &state->players[i];
+        float back_z = team_side(team_of(i)) * back_limit;
+        x[i] = player->point.x;
+        z[i] = player->point.z;
+        max_speed[i] = player->speed;
+        min_x[i] = -side_limit;
+        max_x[i] = side_limit;
+        min_z[i] = fminf(GameConstants::NET_POSITION_Z, back_z);
+        max_z[i] = fmaxf(GameConstants::NET_POSITION_Z, back_z);
+    }
+
+    PlayerKinematics *kinematics = &state->kinematics;
+    KinematicsLanes lanes = {x, z, kinematics->vx, kinematics->vz, kinematics->intent_x, kinematics->intent_z,
+                             kinematics->intent_hold, max_speed, min_x, max_x, min_z, max_z};
+    kinematics_integrate(&lanes, count, dt);
+
+    uint32_t moved = 0;
+    for (int i = 0; i < count; i++)
+    {
+        Player *player = &state->players[i];
+        if (player->point.x != x[i] || player->point.z != z[i])
+            moved |= 1u << i;
+        player->point.x = x[i];
+        player->point.z = z[i];
+    }
+    return moved;
+}
+
+int spawn_decoy_ball(GameState *state, int owner_id, float spread_x)
+{
+    if (state->ball_count >= MAX_BALLS)
+        return -1;
+
+    int index = state->ball_count++;
+    state->balls[index] = state->balls[PRIMARY_BALL];
+    state->balls[index].velocity.x += spread_x;
+    state->ball_roles[index].owner_id = owner_id;
+    state->ball_roles[index].scoring = BALL_SCORING_DECOY;
+    return index;
+}
+
+void remove_ball(GameState *state, int index)
+{
+    if (index <= PRIMARY_BALL || index >= state->ball_count)
+        return;
+
+    int last = --state->ball_count;
+    state->balls[index] = state->balls[last];
+    state->ball_roles[index] = state->ball_roles[last];
+}
+
+void clear_decoy_balls(GameState *state)
+{
+    state->ball_count = 1;
+}
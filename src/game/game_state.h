@@ -2,17 +2,46 @@
 #define GAME_STATE_H
 
 #include "physics/ball_physics.h"
+#include "physics/court_physics.h"
+#include "physics/player_kinematics.h"
 #include "common/GameScore.h"
 #include "common/GamePhase.h"
 #include "common/ability.h"
 #include "common/player.h"
 #include "network/network.h"
+#include "game/ability_engine.h"
+#include "game/score_logic.h"
+#include "game/game_events.h"
+
+// 本球の添字（分身はその後ろに詰めて並ぶ）
+#define PRIMARY_BALL 0
+
+// ボールごとの得点ルール
+typedef enum
+{
+    BALL_SCORING_POINT,  // 本球: バウンド・ネットで得点を判定する
+    BALL_SCORING_DECOY,  // 分身: 得点には関わらず、バウンド・ネット・打たれた時点で消える
+} BallScoring;
 
 typedef struct
 {
-    Ball ball;
+    int owner_id;  // 出したプレイヤー（本球は-1）
+    BallScoring scoring;
+} BallRole;
+
+typedef struct
+{
+    // ボール（balls[PRIMARY_BALL] が本球、1〜ball_count-1 が分身）
+    Ball balls[MAX_BALLS];
+    BallRole ball_roles[MAX_BALLS];
+    int ball_count;
+
     Player players[MAX_CLIENTS];
-    GameScore score;
+    PlayerKinematics kinematics;          // 移動の速度と入力の向き（位置は players[].point）
+    int player_count;                     // この試合の人数（シングルス2、ダブルス4）
+    int team_server_slot[TEAM_COUNT];     // 各チームで現在のゲームのサーブを打つチーム内番号
+    MatchScore score;
+    CourtSurface surface;  // バウンドの物理（試合開始時に決まる）
     float state_timer;
 
     GamePhase phase;
@@ -21,12 +50,34 @@ typedef struct
 
     // 能力状態（プレイヤーごと）
     AbilityState ability_states[MAX_CLIENTS];
+    AbilityEngine ability_engine;  // 発動中の能力と効果
+
+    // このtickに起きた出来事（tickの最後に server_events_dispatch で配る）
+    GameEventQueue events;
 
     // 試合結果（-1: 未確定、0: P1勝利、1: P2勝利）
     int match_winner;
     bool match_result_sent;  // 試合結果送信済みフラグ
 } GameState;
 
-void init_game(GameState *state);
+// player_count: シングルスは2、ダブルスは4
+void init_game(GameState *state, int player_count, const ScoreFormat *format, CourtSurface surface);
+
+// プレイヤーのホームポジションのX座標（シングルスは中央、ダブルスは各レーンの中心）
+float player_home_x(const GameState *state, int player_id);
+
+// 本球を元に分身を出す（spread_x: 本球に対する横方向の速度差）
+// 戻り値: 追加したボールの添字（満杯なら-1）
+int spawn_decoy_ball(GameState *state, int owner_id, float spread_x);
+
+// 全プレイヤーの移動を dt 秒進める（コートの自陣側とその周りから出さない）
+// 戻り値: 位置が変わったプレイヤーのビット集合
+uint32_t update_player_kinematics(GameState *state, float dt);
+
+// 分身を消す（末尾と入れ替えて詰める、本球は消せない）
+void remove_ball(GameState *state, int index);
+
+// 分身をすべて消す
+void clear_decoy_balls(GameState *state);
 void update_game(GameState *state, float dt);
 #endif
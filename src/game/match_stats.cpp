@@ -0,0 +1,43 @@
+#include "match_stats.h"
+#include <string.h>
+#include "common/GamePhase.h"
+
+void match_stats_reset(MatchStats *stats)
+{
+    memset(stats, 0, sizeof(MatchStats));
+}
+
+static void apply_event(MatchStats *stats, const GameEvent *event)
+{
+    switch (event->type)
+    {
+        case GAME_EVENT_PHASE_CHANGED:
+            // 接続待ちからの開始が新しい試合
+            if (event->detail == (uint32_t)GAME_PHASE_WAIT_FOR_MATCH)
+                match_stats_reset(stats);
+            break;
+        case GAME_EVENT_BALL_HIT:
+            if (event->player_id >= 0 && event->player_id < MAX_CLIENTS)
+                stats->hits[event->player_id]++;
+            stats->rally_hits++;
+            break;
+        case GAME_EVENT_POINT_SCORED:
+            if (event->value >= 0 && event->value < TEAM_COUNT)
+                stats->points_won[event->value]++;
+            stats->rallies++;
+            stats->total_rally_hits += stats->rally_hits;
+            if (stats->rally_hits > stats->longest_rally)
+                stats->longest_rally = stats->rally_hits;
+            stats->rally_hits = 0;
+            break;
+        case GAME_EVENT_ABILITY_CHANGED:
+            stats->ability_changes++;
+            break;
+    }
+}
+
+void match_stats_apply(MatchStats *stats, const GameEvent *events, int count)
+{
+    for (int i = 0; i < count; i++)
+        apply_event(stats, &events[i]);
+}
@@ -0,0 +1,25 @@
+#ifndef MATCH_STATS_H
+#define MATCH_STATS_H
+
+#include <stdint.h>
+#include "game/game_events.h"
+#include "network/network.h"
+
+// 試合の統計（試合イベントから集計する）
+struct MatchStats
+{
+    uint32_t hits[MAX_CLIENTS];         // プレイヤーごとの打球数
+    uint32_t points_won[TEAM_COUNT];    // チームごとの得点数
+    uint32_t rallies;                   // 得点で終わったラリーの数
+    uint32_t rally_hits;                // 現在のラリーの打数
+    uint32_t total_rally_hits;          // 得点で終わったラリーの打数の合計
+    uint32_t longest_rally;
+    uint32_t ability_changes;
+};
+
+void match_stats_reset(MatchStats *stats);
+
+// イベントをまとめて集計する（試合開始のフェーズ変更で0に戻す）
+void match_stats_apply(MatchStats *stats, const GameEvent *events, int count);
+
+#endif
@@ -1,22 +1,23 @@
 #include "point_judge.h"
 #include "physics/court_check.h"
 #include "common/game_constants.h"
+#include "game/team.h"
 
 int judge_point(GameState *state)
 {
     if (!state || state->phase != GAME_PHASE_IN_RALLY)
         return GameConstants::PLAYER_ID_INVALID;
 
-    Ball *ball = &state->ball;
+    Ball *ball = &state->balls[PRIMARY_BALL];
     bool is_in = is_in_court(ball->point);
 
     // アウト: 1回目のバウンドでコート外
     if (ball->bounce_count == 1 && !is_in)
-        return GameConstants::get_opponent_player_id(ball->last_hit_player_id);
+        return opponent_team(team_of(ball->last_hit_player_id));
 
-    // ツーバウンド: 打った人の得点
+    // ツーバウンド: 打ったチームの得点
     if (ball->bounce_count == 2)
-        return ball->last_hit_player_id;
+        return team_of(ball->last_hit_player_id);
 
     return GameConstants::PLAYER_ID_INVALID;
 }
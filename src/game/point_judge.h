@@ -16,7 +16,7 @@ enum PointJudgeResult {
 extern const char* point_judge_result_strings[POINT_JUDGE_COUNT];
 
 // 得点判定を実行
-// 戻り値: 勝者のプレイヤーID（PLAYER_ID_INVALID = 判定なし）
+// 戻り値: 得点したチーム（シングルスではプレイヤーIDと同じ、PLAYER_ID_INVALID = 判定なし）
 int judge_point(GameState *state);
 
 #endif // POINT_JUDGE_H
@@ -1,65 +1,228 @@
 #include "score_logic.h"
+#include <string.h>
 #include "../log.h"
 #include "../server_constants.h"
 
-void init_score(GameScore *score)
+const ScoreFormat SCORE_FORMAT_SHORT = { SETS_TO_WIN, 1, false, false, false };
+static const ScoreFormat SCORE_FORMAT_BEST_OF_3 = { 2, 6, false, true, false };
+static const ScoreFormat SCORE_FORMAT_BEST_OF_5 = { 3, 6, false, true, false };
+
+constexpr int TIEBREAK_POINTS = 7;
+constexpr int MATCH_TIEBREAK_POINTS = 10;
+
+// ゲーム内のポイント状態
+// 0〜15: P1の段階 * 4 + P2の段階（段階 0〜3 が 0/15/30/40）、40-40 がデュース
+enum : uint8_t
+{
+    POINT_DEUCE = 3 * 4 + 3,
+    POINT_ADVANTAGE_P1,
+    POINT_ADVANTAGE_P2,
+    POINT_STATE_COUNT,
+    POINT_GAME_P1 = POINT_STATE_COUNT,  // 終端（ゲーム獲得）
+    POINT_GAME_P2,
+};
+
+struct PointTransition
+{
+    uint8_t next;    // 次の状態（POINT_GAME_P1/P2 ならゲーム終了）
+    uint8_t events;  // ScoreEvent
+};
+
+// [no_ad][状態][得点した側] の遷移表と、状態ごとの表示ポイント
+struct PointTable
+{
+    PointTransition next[2][POINT_STATE_COUNT][2];
+    uint8_t display[POINT_STATE_COUNT][2];
+};
+
+static constexpr PointTransition point_transition(int state, int winner, bool no_ad)
 {
-    score->point_p1 = 0;
-    score->point_p2 = 0;
-    score->sets_p1 = 0;
-    score->sets_p2 = 0;
+    const uint8_t game = (uint8_t)(POINT_GAME_P1 + winner);
+
+    if (state == POINT_ADVANTAGE_P1 || state == POINT_ADVANTAGE_P2)
+    {
+        if (winner == state - POINT_ADVANTAGE_P1)
+            return { game, SCORE_EVENT_GAME };
+        return { POINT_DEUCE, SCORE_EVENT_DEUCE };
+    }
+
+    int stage[2] = { state / 4, state % 4 };
+    if (stage[winner] < 3)
+    {
+        stage[winner]++;
+        uint8_t next = (uint8_t)(stage[0] * 4 + stage[1]);
+        return { next, (uint8_t)(next == POINT_DEUCE ? SCORE_EVENT_DEUCE : 0) };
+    }
+
+    // 40から取ればゲーム、デュースからはアドバンテージ（ノーアドならゲーム）
+    if (stage[1 - winner] < 3 || no_ad)
+        return { game, SCORE_EVENT_GAME };
+    return { (uint8_t)(POINT_ADVANTAGE_P1 + winner), SCORE_EVENT_ADVANTAGE };
+}
+
+static constexpr PointTable build_point_table()
+{
+    constexpr uint8_t STAGE_POINTS[4] = { TENNIS_SCORE_LOVE, TENNIS_SCORE_FIFTEEN, TENNIS_SCORE_THIRTY, TENNIS_SCORE_FORTY };
+
+    PointTable table = {};
+    for (int state = 0; state < POINT_STATE_COUNT; state++)
+    {
+        for (int winner = 0; winner < 2; winner++)
+        {
+            table.next[0][state][winner] = point_transition(state, winner, false);
+            table.next[1][state][winner] = point_transition(state, winner, true);
+        }
+
+        if (state < POINT_ADVANTAGE_P1)
+        {
+            table.display[state][0] = STAGE_POINTS[state / 4];
+            table.display[state][1] = STAGE_POINTS[state % 4];
+        }
+        else
+        {
+            int holder = state - POINT_ADVANTAGE_P1;
+            table.display[state][holder] = TENNIS_SCORE_ADVANTAGE;
+            table.display[state][1 - holder] = TENNIS_SCORE_FORTY;
+        }
+    }
+    return table;
+}
+
+static constexpr PointTable POINT_TABLE = build_point_table();
+
+static_assert(POINT_TABLE.next[0][3 * 4 + 2][0].next == POINT_GAME_P1, "40-30 -> game");
+static_assert(POINT_TABLE.next[0][POINT_DEUCE][1].next == POINT_ADVANTAGE_P2, "deuce -> advantage");
+static_assert(POINT_TABLE.next[0][POINT_ADVANTAGE_P2][0].next == POINT_DEUCE, "advantage lost -> deuce");
+static_assert(POINT_TABLE.next[1][POINT_DEUCE][1].next == POINT_GAME_P2, "no-ad deciding point");
+
+bool score_format_from_name(const char *name, ScoreFormat *format)
+{
+    if (strcmp(name, "short") == 0)
+        *format = SCORE_FORMAT_SHORT;
+    else if (strcmp(name, "best_of_3") == 0)
+        *format = SCORE_FORMAT_BEST_OF_3;
+    else if (strcmp(name, "best_of_5") == 0)
+        *format = SCORE_FORMAT_BEST_OF_5;
+    else
+        return false;
+    return true;
 }
 
-static bool award_set(GameScore *score, int winner)
+static void update_view(MatchScore *score)
 {
-    if (winner == 0)
-        score->sets_p1++;
+    if (score->tiebreak_target > 0)
+    {
+        score->view.point_p1 = score->tiebreak_points[0];
+        score->view.point_p2 = score->tiebreak_points[1];
+    }
     else
-        score->sets_p2++;
+    {
+        score->view.point_p1 = POINT_TABLE.display[score->point_state][0];
+        score->view.point_p2 = POINT_TABLE.display[score->point_state][1];
+    }
+    score->view.sets_p1 = score->sets[0];
+    score->view.sets_p2 = score->sets[1];
+}
 
-    score->point_p1 = 0;
-    score->point_p2 = 0;
+void init_score(MatchScore *score, const ScoreFormat *format)
+{
+    memset(score, 0, sizeof(MatchScore));
+    score->format = *format;
+    if (score->format.sets_to_win < 1) score->format.sets_to_win = 1;
+    if (score->format.games_per_set < 1) score->format.games_per_set = 1;
+
+    update_view(score);
+    score->pending_events = SCORE_EVENT_RESET;
+}
+
+static uint32_t award_set(MatchScore *score, int winner)
+{
+    score->sets[winner]++;
+    score->games[0] = 0;
+    score->games[1] = 0;
 
     if (match_finished(score))
     {
-        LOG_SUCCESS("試合終了！Player " << (winner + 1) << " の勝利");
-        return false;
+        LOG_SUCCESS("試合終了！チーム " << (winner + 1) << " の勝利");
+        return SCORE_EVENT_SET | SCORE_EVENT_MATCH;
     }
 
-    LOG_SUCCESS("セット獲得: " << score->sets_p1 << " - " << score->sets_p2);
-    return true;
+    LOG_SUCCESS("セット獲得: " << score->sets[0] << " - " << score->sets[1]);
+
+    // 最終セットはマッチタイブレークのみ
+    const int last = score->format.sets_to_win - 1;
+    if (score->format.match_tiebreak && score->sets[0] == last && score->sets[1] == last)
+    {
+        score->tiebreak_target = MATCH_TIEBREAK_POINTS;
+        return SCORE_EVENT_SET | SCORE_EVENT_TIEBREAK;
+    }
+    return SCORE_EVENT_SET;
 }
 
-bool add_point(GameScore *score, int winner)
+static uint32_t award_game(MatchScore *score, int winner)
 {
-    int *win_pt = (winner == 0) ? &score->point_p1 : &score->point_p2;
+    const bool was_tiebreak = score->tiebreak_target > 0;
+
+    score->games[winner]++;
+    score->point_state = 0;
+    score->tiebreak_points[0] = 0;
+    score->tiebreak_points[1] = 0;
+    score->tiebreak_target = 0;
 
-    switch (*win_pt)
+    // 1ゲームで1セットの形式以外は2ゲーム差が必要
+    const int need = score->format.games_per_set;
+    const int lead = (need > 1) ? 2 : 1;
+    if (was_tiebreak || (score->games[winner] >= need && score->games[winner] - score->games[1 - winner] >= lead))
+        return SCORE_EVENT_GAME | award_set(score, winner);
+
+    if (score->format.tiebreak && score->games[0] == need && score->games[1] == need)
     {
-        case 0:  *win_pt = 15; break;
-        case 15: *win_pt = 30; break;
-        case 30: *win_pt = 40; break;
-        case 40:
-            *win_pt = 50;
-            return award_set(score, winner);
+        score->tiebreak_target = TIEBREAK_POINTS;
+        return SCORE_EVENT_GAME | SCORE_EVENT_TIEBREAK;
     }
-    return true;
+    return SCORE_EVENT_GAME;
+}
+
+uint32_t add_point(MatchScore *score, int team)
+{
+    const int winner = (team == 0) ? 0 : 1;
+    uint32_t events = SCORE_EVENT_POINT;
+
+    if (score->tiebreak_target > 0)
+    {
+        int points = ++score->tiebreak_points[winner];
+        if (points >= score->tiebreak_target && points - score->tiebreak_points[1 - winner] >= 2)
+            events |= award_game(score, winner);
+    }
+    else
+    {
+        const PointTransition *transition = &POINT_TABLE.next[score->format.no_ad ? 1 : 0][score->point_state][winner];
+        events |= transition->events;
+        if (transition->next >= POINT_STATE_COUNT)
+            events |= award_game(score, winner);
+        else
+            score->point_state = transition->next;
+    }
+
+    update_view(score);
+    score->pending_events |= events;
+    return events;
 }
 
-void print_score(const GameScore *score)
+void print_score(const MatchScore *score)
 {
     // ログ削減のため空実装
     (void)score;
 }
 
-bool match_finished(const GameScore *score)
+bool match_finished(const MatchScore *score)
 {
-    return (score->sets_p1 >= SETS_TO_WIN || score->sets_p2 >= SETS_TO_WIN);
+    return (score->sets[0] >= score->format.sets_to_win || score->sets[1] >= score->format.sets_to_win);
 }
 
-int get_match_winner(const GameScore *score)
+int get_match_winner(const MatchScore *score)
 {
-    if (score->sets_p1 >= SETS_TO_WIN) return 0;
-    if (score->sets_p2 >= SETS_TO_WIN) return 1;
+    if (score->sets[0] >= score->format.sets_to_win) return 0;
+    if (score->sets[1] >= score->format.sets_to_win) return 1;
     return -1;
 }
@@ -1,16 +1,65 @@
 #ifndef SCORE_LOGIC_H
 #define SCORE_LOGIC_H
 
+#include <stdint.h>
 #include "common/GameScore.h"
 
+// 試合形式
+typedef struct
+{
+    int sets_to_win;       // 勝利に必要なセット数（2: 3セットマッチ、3: 5セットマッチ）
+    int games_per_set;     // セット獲得に必要なゲーム数（1: 1ゲームで1セットのショート形式）
+    bool no_ad;            // デュースの次のポイントでゲームが決まる
+    bool tiebreak;         // games_per_set オールでタイブレーク（7ポイント先取・2点差）
+    bool match_tiebreak;   // 最終セットを10ポイントのタイブレークで行う
+} ScoreFormat;
+
+// 1ポイントで起きたこと（ビットマスク、送信するまで MatchScore.pending_events に溜まる）
+enum ScoreEvent
+{
+    SCORE_EVENT_RESET     = 1 << 0,  // スコア初期化（全体を送り直す）
+    SCORE_EVENT_POINT     = 1 << 1,
+    SCORE_EVENT_DEUCE     = 1 << 2,
+    SCORE_EVENT_ADVANTAGE = 1 << 3,
+    SCORE_EVENT_GAME      = 1 << 4,
+    SCORE_EVENT_TIEBREAK  = 1 << 5,  // タイブレーク開始
+    SCORE_EVENT_SET       = 1 << 6,
+    SCORE_EVENT_MATCH     = 1 << 7,
+};
+
+// 試合のスコア一式
+typedef struct
+{
+    ScoreFormat format;
+
+    // クライアントへ送る表示用スコア（SCORE_UPDATE のペイロード）
+    // ポイントは 0/15/30/40/50(アドバンテージ)、タイブレーク中は取得ポイント数
+    GameScore view;
+
+    uint8_t point_state;     // ゲーム内のポイント状態（遷移表の添字）
+    int sets[2];
+    int games[2];            // 現在のセットのゲーム数
+    int tiebreak_points[2];
+    int tiebreak_target;     // 0: タイブレーク中でない、7 または 10
+
+    uint32_t pending_events; // 未送信の ScoreEvent
+} MatchScore;
+
+// 従来どおり1ゲームで1セットを取るショート形式（デュースあり）
+extern const ScoreFormat SCORE_FORMAT_SHORT;
+
+// 形式名（short / best_of_3 / best_of_5）から設定する（不明な名前ならfalse）
+bool score_format_from_name(const char *name, ScoreFormat *format);
+
 // スコアを初期化 (0-0 スタート) する関数
-void init_score(GameScore *score);
-// ポイントを加算する関数
-bool add_point(GameScore *score, int player_index);
+void init_score(MatchScore *score, const ScoreFormat *format);
+// ポイントを加算する関数（team: 0 または 1）
+// 戻り値: このポイントで起きた ScoreEvent
+uint32_t add_point(MatchScore *score, int team);
 // スコアを表示する関数
-void print_score(const GameScore *score);
+void print_score(const MatchScore *score);
 // マッチ終了判定
-bool match_finished(const GameScore *score);
+bool match_finished(const MatchScore *score);
 // 勝者を返す（-1: まだ決まっていない、0: P1、1: P2）
-int get_match_winner(const GameScore *score);
-#endif // SCORE_LOGIC_H
\ No newline at end of file
+int get_match_winner(const MatchScore *score);
+#endif // SCORE_LOGIC_H
@@ -0,0 +1,21 @@
+#ifndef TEAM_H
+#define TEAM_H
+
+#include "network/network.h"
+
+// チーム分け: 偶数IDがチーム0（手前側 Z > 0）、奇数IDがチーム1（奥側 Z < 0）
+// シングルスではプレイヤーIDとチーム番号が一致する（スコアのp1/p2はチーム単位）
+
+inline int team_of(int player_id) { return player_id % TEAM_COUNT; }
+
+inline int opponent_team(int team) { return TEAM_COUNT - 1 - team; }
+
+// チーム内の番号（ダブルスでは0が左レーン、1が右レーン）
+inline int team_slot_of(int player_id) { return player_id / TEAM_COUNT; }
+
+inline int team_player(int team, int slot) { return team + slot * TEAM_COUNT; }
+
+// チームのコート側（Z符号）
+inline float team_side(int team) { return (team == 0) ? 1.0f : -1.0f; }
+
+#endif
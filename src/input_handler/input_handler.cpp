@@ -1,9 +1,9 @@
 #include "input_handler.h"
-#include "player/player_manager.h"
 #include "physics/ball_physics.h"
 #include "game/game_phase_manager.h"
+#include "game/team.h"
 #include "common/game_constants.h"
-#include "common/ability.h"
+#include "game/ability_engine.h"
 #include "../server_constants.h"
 #include "../log.h"
 #include <math.h>
@@ -49,6 +49,26 @@ static Point3d calculate_shot_direction(Player *player, float acc_x, float acc_y
     return normalize_direction(dir);
 }
 
+// 打球の種類ごとの補正（添字: 0 通常、1 ロブ）
+// 通常の打球はすべて1倍なので、種類による分岐なしで同じ式を通す
+struct ShotProfile
+{
+    float speed_multiplier;
+    float velocity_y_scale;
+    float velocity_z_scale;
+    float gravity_multiplier;
+};
+
+static constexpr ShotProfile SHOT_PROFILES[2] = {
+    {1.0f, 1.0f, 1.0f, 1.0f},
+    {LOB_SHOT_SPEED_MULTIPLIER, LOB_SHOT_Y_BOOST, LOB_SHOT_Z_BOOST, LOB_SHOT_GRAVITY_MULTIPLIER},
+};
+
+bool input_handler_accepts_shot_type(long long raw_type)
+{
+    return raw_type == 0 || raw_type == (long long)SHOT_TYPE_LOB;
+}
+
 static float calculate_shot_speed(float acc_x, float acc_y, float acc_z)
 {
     float acc_magnitude = sqrtf(acc_x * acc_x + acc_y * acc_y + acc_z * acc_z);
@@ -59,75 +79,82 @@ static float calculate_shot_speed(float acc_x, float acc_y, float acc_z)
 static void handle_player_swing(GameState *state, int player_id, float acc_x, float acc_y, float acc_z, int shot_type)
 {
     Player *player = &state->players[player_id];
-    Ball *ball = &state->ball;
 
     if (!is_swing_allowed_phase(state->phase))
         return;
 
-    float dx = player->point.x - ball->point.x;
-    float dy = player->point.y - ball->point.y;
-    float dz = player->point.z - ball->point.z;
-    float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+    // 届く範囲で最も近いボールを本球・分身ごとに探す
+    // 本球が届くならそちらを打つ（分身が近くにあるだけで本球を空振りさせない）
+    int nearest_index[2] = {-1, -1};
+    float nearest_dist[2] = {PLAYER_SWING_RADIUS, PLAYER_SWING_RADIUS};
+    for (int i = 0; i < state->ball_count; i++)
+    {
+        const Ball *candidate = &state->balls[i];
+        float dx = player->point.x - candidate->point.x;
+        float dy = player->point.y - candidate->point.y;
+        float dz = player->point.z - candidate->point.z;
+        float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+        int decoy = state->ball_roles[i].scoring == BALL_SCORING_DECOY;
+        if (dist <= nearest_dist[decoy])
+        {
+            nearest_dist[decoy] = dist;
+            nearest_index[decoy] = i;
+        }
+    }
+
+    int target = (nearest_index[0] >= 0) ? nearest_index[0] : nearest_index[1];
+    if (target < 0)
+        return;
 
-    if (dist > PLAYER_SWING_RADIUS)
+    // 分身を打った場合はそれが消えるだけ（スイングは空振り扱い）
+    if (state->ball_roles[target].scoring == BALL_SCORING_DECOY)
+    {
+        remove_ball(state, target);
         return;
+    }
+
+    Ball *ball = &state->balls[target];
 
     Point3d dir = calculate_shot_direction(player, acc_x, acc_y, acc_z);
     float speed = calculate_shot_speed(acc_x, acc_y, acc_z);
 
-    bool is_lob = (shot_type == SHOT_TYPE_LOB);
-    if (is_lob)
-        speed *= LOB_SHOT_SPEED_MULTIPLIER;
+    const ShotProfile *shot = &SHOT_PROFILES[shot_type == SHOT_TYPE_LOB];
 
-    handle_racket_hit(ball, dir, speed);
+    handle_racket_hit(ball, dir, speed * shot->speed_multiplier);
     ball->velocity.z *= Z_VELOCITY_DAMPING;
+    ball->velocity.y *= shot->velocity_y_scale;
+    ball->velocity.z *= shot->velocity_z_scale;
+    ball->gravity_multiplier = shot->gravity_multiplier;
 
-    if (is_lob)
-    {
-        ball->velocity.y *= LOB_SHOT_Y_BOOST;
-        ball->velocity.z *= LOB_SHOT_Z_BOOST;
-        ball->gravity_multiplier = LOB_SHOT_GRAVITY_MULTIPLIER;
-    }
-    else
-    {
-        ball->gravity_multiplier = 1.0f;
-    }
-
-    AbilityState *ability_state = &state->ability_states[player_id];
-    if (ability_state->active_ability == ABILITY_SPEED_UP && ability_state->remaining_frames > 0)
-    {
-        ball->velocity.z *= 3.0f;
-        ball->gravity_multiplier = 2.0f;
-        ability_state->active_ability = ABILITY_NONE;
-        ability_state->remaining_frames = 0;
-    }
+    int ability_before = state->ability_states[player_id].active_ability;
+    int decoys = ability_engine_apply_hit(&state->ability_engine, state->ability_states, player_id, ball);
+    if (ability_before != ABILITY_NONE && state->ability_states[player_id].active_ability == ABILITY_NONE)
+        game_events_push(&state->events, GAME_EVENT_ABILITY_CHANGED, player_id, -1, 0);
 
     ball->last_hit_player_id = player_id;
     ball->bounce_count = 0;
     ball->hit_count++;
+    game_events_push(&state->events, GAME_EVENT_BALL_HIT, player_id, shot_type, 0);
 
     if (state->phase == GAME_PHASE_START_GAME)
     {
         set_game_phase(state, GAME_PHASE_IN_RALLY);
         ball->hit_count = 1;
     }
-}
 
-static void clamp_player_to_court(Player *player, int player_id)
-{
-    if (player_id == 0 && player->point.z < GameConstants::NET_POSITION_Z)
-        player->point.z = GameConstants::NET_POSITION_Z;
-    else if (player_id == 1 && player->point.z > GameConstants::NET_POSITION_Z)
-        player->point.z = GameConstants::NET_POSITION_Z;
+    // 分身は打球の左右に交互に広げる
+    for (int i = 0; i < decoys; i++)
+    {
+        float side = (i % 2 == 0) ? 1.0f : -1.0f;
+        spawn_decoy_ball(state, player_id, side * DECOY_BALL_SPREAD_X * (float)(i / 2 + 1));
+    }
 }
 
-void apply_player_input(GameState *state, int player_id, const PlayerInput *input, float deltaTime)
+void apply_player_input(GameState *state, int player_id, const PlayerInput *input)
 {
-    if (!GameConstants::is_valid_player_id(player_id))
+    if (player_id < 0 || player_id >= state->player_count)
         return;
 
-    Player *player = &state->players[player_id];
-
     float move_x = 0.0f;
     float move_z = 0.0f;
 
@@ -136,13 +163,13 @@ void apply_player_input(GameState *state, int player_id, const PlayerInput *inpu
     if (input->front) move_z -= 1.0f;
     if (input->back) move_z += 1.0f;
 
-    player_move(player, move_x, 0.0f, move_z, deltaTime);
-    clamp_player_to_court(player, player_id);
+    // 位置は update_player_kinematics でtickごとに進める
+    player_kinematics_set_intent(&state->kinematics, player_id, move_x, move_z);
 }
 
 void apply_player_swing(GameState *state, int player_id, const PlayerSwing *swing)
 {
-    if (!GameConstants::is_valid_player_id(player_id))
+    if (player_id < 0 || player_id >= state->player_count)
         return;
 
     handle_player_swing(state, player_id, swing->acc_x, swing->acc_y, swing->acc_z, swing->shot_type);
@@ -6,5 +6,8 @@
 #include "common/ball.h"
 #include "game/game_state.h"
 
-void apply_player_input(GameState *state, int player_id, const PlayerInput *input, float deltaTime);
+void apply_player_input(GameState *state, int player_id, const PlayerInput *input);
 void apply_player_swing(GameState *state, int player_id, const PlayerSwing *swing);
+
+// 受信したショット種別の値を列挙型として読んでよいか（打ち方の表にある通常（0）とロブのみ）
+bool input_handler_accepts_shot_type(long long raw_type);
@@ -0,0 +1,70 @@
+#include "input_validator.h"
+#include <math.h>
+#include "../server_constants.h"
+
+void input_validator_init(InputValidator *validator, Uint32 now_ms)
+{
+    validator->last_swing_ms = now_ms;
+    validator->has_swung = false;
+    validator->acc_mean = 0.0f;
+    validator->acc_variance = 0.0f;
+    validator->acc_samples = 0;
+    validator->acc_varied = false;
+    validator->rejected_swings = 0;
+    validator->flagged_swings = 0;
+    validator->reported_total = 0;
+}
+
+bool input_validator_check_swing(InputValidator *validator, const PlayerSwing *swing, Uint32 now_ms)
+{
+    // センサーの範囲外・非数は捨てる
+    float magnitude_sq = swing->acc_x * swing->acc_x + swing->acc_y * swing->acc_y + swing->acc_z * swing->acc_z;
+    if (!isfinite(magnitude_sq) || magnitude_sq > ANTI_CHEAT_ACC_LIMIT * ANTI_CHEAT_ACC_LIMIT)
+    {
+        validator->rejected_swings++;
+        return false;
+    }
+
+    // 人が振れる間隔より短い連打は捨てる
+    if (validator->has_swung && (int)(now_ms - validator->last_swing_ms) < ANTI_CHEAT_MIN_SWING_INTERVAL_MS)
+    {
+        validator->rejected_swings++;
+        return false;
+    }
+    validator->has_swung = true;
+    validator->last_swing_ms = now_ms;
+
+    // 大きさの指数移動平均からの外れ具合と、毎回同じ値（ばらつきがない）を記録する
+    // キーやボタンで振るクライアントは最初から毎回同じ値を送るので、
+    // 同じ値が続くのを不自然とみなすのは、一度でも大きさが変わった（センサーで振っていた）クライアントだけ
+    float magnitude = sqrtf(magnitude_sq);
+    float deviation = magnitude - validator->acc_mean;
+    if (validator->acc_samples > 0 && fabsf(deviation) >= ANTI_CHEAT_ACC_MIN_STDDEV)
+        validator->acc_varied = true;
+    if (validator->acc_samples >= ANTI_CHEAT_ACC_WARMUP_SWINGS)
+    {
+        float stddev = sqrtf(validator->acc_variance);
+        if (fabsf(deviation) > ANTI_CHEAT_ACC_OUTLIER_SIGMA * stddev + ANTI_CHEAT_ACC_OUTLIER_MARGIN ||
+            (validator->acc_varied && stddev < ANTI_CHEAT_ACC_MIN_STDDEV))
+            validator->flagged_swings++;
+    }
+    else
+    {
+        validator->acc_samples++;
+    }
+
+    // 最初の数回は平均を早く追従させる
+    float alpha = (validator->acc_samples < ANTI_CHEAT_ACC_WARMUP_SWINGS) ? 1.0f / (float)validator->acc_samples
+                                                                           : ANTI_CHEAT_ACC_EWMA_ALPHA;
+    validator->acc_mean += alpha * deviation;
+    validator->acc_variance = (1.0f - alpha) * (validator->acc_variance + alpha * deviation * deviation);
+    return true;
+}
+
+uint32_t input_validator_take_report(InputValidator *validator)
+{
+    uint32_t total = validator->rejected_swings + validator->flagged_swings;
+    uint32_t added = total - validator->reported_total;
+    validator->reported_total = total;
+    return added;
+}
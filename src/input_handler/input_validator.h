@@ -0,0 +1,38 @@
+#ifndef INPUT_VALIDATOR_H
+#define INPUT_VALIDATOR_H
+
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "common/player_swing.h"
+
+// クライアント入力の妥当性検査（接続ごと）
+// スイングを1入力あたり定数時間で判定する（移動は向きだけなので速度の上限は運動計算側で守られる）
+struct InputValidator
+{
+    // スイング間隔
+    Uint32 last_swing_ms;
+    bool has_swung;
+
+    // スイング加速度の大きさの指数移動平均と分散
+    float acc_mean;
+    float acc_variance;
+    uint32_t acc_samples;
+    bool acc_varied;  // 大きさが変わるスイングがあった（アナログのセンサーで振っている）
+
+    // 検出件数（累計）
+    uint32_t rejected_swings;
+    uint32_t flagged_swings;   // 統計的に不自然（反映はする）
+    uint32_t reported_total;   // 前回ログ出力時点の合計
+};
+
+// 新しい接続用に初期化
+void input_validator_init(InputValidator *validator, Uint32 now_ms);
+
+// スイングを検査する
+// 不正な値・短すぎる間隔ならfalse（スイングを捨てる）、統計的な外れ値は記録だけしてtrue
+bool input_validator_check_swing(InputValidator *validator, const PlayerSwing *swing, Uint32 now_ms);
+
+// 前回の呼び出し以降に増えた検出件数（ログ出力用）
+uint32_t input_validator_take_report(InputValidator *validator);
+
+#endif
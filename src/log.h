@@ -20,6 +20,10 @@ inline bool g_debug_log_enabled = false;
 #define LOG_WARN(message) \
     do { if (g_debug_log_enabled) std::cerr << ANSI_YELLOW "[!] " << message << ANSI_RESET << std::endl; } while(0)
 
+// 運用向けの定期報告（--debug-log がなくても出す、呼び出し側で出力間隔を抑えること）
+#define LOG_REPORT(message) \
+    do { std::cerr << ANSI_YELLOW "[!] " << message << ANSI_RESET << std::endl; } while(0)
+
 // 成功ログ
 #define LOG_SUCCESS(message) \
     do { if (g_debug_log_enabled) std::cerr << ANSI_GREEN << "[o] " << message << ANSI_RESET << std::endl; } while(0)
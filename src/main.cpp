@@ -7,41 +7,168 @@
 #include "log.h"
 #include "core/server_init.h"
 #include "core/server_loop.h"
+#include "core/server_config.h"
+#include "core/event_loop.h"
+#include "core/headless.h"
+#include "core/worker_pool.h"
+#include "server_constants.h"
 
 // グローバル変数: Ctrl+C対応
 // シグナルハンドラーから参照するため、グローバルに配置
 volatile int g_running = 1;
 
-// コマンドライン引数から取得するポート（デフォルト: 5000）
-static int g_port = 5000;
+// SIGTERM: 新規受付を止めて進行中の試合の終了後に終了（2回目は即終了）
+// SIGUSR2: 新プロセスへリスナーを渡してからドレイン
+static volatile int g_drain_requested = 0;
+static volatile int g_restart_requested = 0;
+
+// シグナル受信時にイベントループを起こすためのeventfd
+static int g_wake_fd = -1;
+
+// 実行時設定（デフォルト値 → 設定ファイル → コマンドライン引数）
+static ServerConfig g_config;
+
+// ヘッドレス実行の指定（match_count 0: 通常のサーバーとして起動）
+static HeadlessOptions g_headless = {};
+
+// 受信パケット列を再生するファイル（nullptr: 再生しない）
+static const char *g_packet_stream_path = nullptr;
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s [options]\n", program);
+    printf("Options:\n");
+    printf("  --config, -c <file>  Load settings from file (key = value)\n");
+    printf("  --port, -p <port>  Server port (default: 5000)\n");
+    printf("  --spectator-port <port>  Spectator port (default: port + 1, 0: disabled)\n");
+    printf("  --sim-hz <hz>      Simulation rate (default: client frame rate)\n");
+    printf("  --snapshot-hz <hz> Player snapshot rate (default: simulation rate)\n");
+    printf("  --spectator-snapshot-hz <hz>  Spectator snapshot rate (default: %d)\n", DEFAULT_SPECTATOR_SNAPSHOT_HZ);
+    printf("  --idle-broadcast-hz <hz>  Idle player state rate (default: %d)\n", DEFAULT_PLAYER_IDLE_BROADCAST_HZ);
+    printf("  --checkpoint <file>  Checkpoint match state to file and resume from it on restart\n");
+    printf("  --checkpoint-hz <hz>  Checkpoint rate (default: %d)\n", DEFAULT_CHECKPOINT_HZ);
+    printf("  --admin-socket <path>  Serve the admin console on a Unix domain socket\n");
+    printf("  --workers <count>  Worker processes behind a single acceptor (default: 1)\n");
+    printf("  --doubles          Play doubles (2 vs 2) matches\n");
+    printf("  --score-format <name>  short (default), best_of_3 or best_of_5\n");
+    printf("  --court <surface>  hard (default), clay or grass\n");
+    printf("  --no-ad            Decide deuce games with a single point\n");
+    printf("  --match-tiebreak   Play the final set as a 10-point tiebreak\n");
+    printf("  --ai <count>       Fill player slots with server-side AI (default: 0)\n");
+    printf("  --headless <matches>  Run AI-vs-AI matches without networking and exit\n");
+    printf("  --trace-record <file>  With --headless, write a per-tick state hash trace\n");
+    printf("  --trace-verify <file>  With --headless, compare against a recorded trace (exit 1 on divergence)\n");
+    printf("  --packet-stream <file>  Feed raw client bytes from file (- for stdin) through packet dispatch and exit\n");
+    printf("  --fuzz <seed>      With --headless, randomize AI seeds and skill and check state invariants every tick\n");
+    printf("  --debug-log, -d    Enable debug logging\n");
+    printf("  --help             Show this help\n");
+}
+
+// 設定項目に対応するコマンドライン引数
+// 値はそのまま server_config_set_value へ渡す（値を取らない引数は flag_value を渡す）
+struct ConfigOption
+{
+    const char *name;
+    const char *short_name;  // nullptr: なし
+    const char *key;
+    const char *flag_value;  // nullptr: 次の引数を値として取る
+};
+
+static const ConfigOption CONFIG_OPTIONS[] = {
+    {"--port", "-p", "port", nullptr},
+    {"--spectator-port", nullptr, "spectator_port", nullptr},
+    {"--sim-hz", nullptr, "simulation_hz", nullptr},
+    {"--snapshot-hz", nullptr, "snapshot_hz", nullptr},
+    {"--spectator-snapshot-hz", nullptr, "spectator_snapshot_hz", nullptr},
+    {"--idle-broadcast-hz", nullptr, "player_idle_broadcast_hz", nullptr},
+    {"--checkpoint", nullptr, "checkpoint_path", nullptr},
+    {"--checkpoint-hz", nullptr, "checkpoint_hz", nullptr},
+    {"--admin-socket", nullptr, "admin_socket_path", nullptr},
+    {"--workers", nullptr, "workers", nullptr},
+    {"--doubles", nullptr, "mode", "doubles"},
+    {"--score-format", nullptr, "score_format", nullptr},
+    {"--court", nullptr, "court", nullptr},
+    {"--no-ad", nullptr, "no_ad", "true"},
+    {"--match-tiebreak", nullptr, "match_tiebreak", "true"},
+    {"--ai", nullptr, "ai_players", nullptr},
+    {"--debug-log", "-d", "debug_log", "true"},
+};
+
+static const ConfigOption *find_config_option(const char *arg)
+{
+    for (const ConfigOption &option : CONFIG_OPTIONS)
+    {
+        if (strcmp(arg, option.name) == 0 || (option.short_name && strcmp(arg, option.short_name) == 0))
+            return &option;
+    }
+    return nullptr;
+}
 
 // コマンドライン引数のパース
 static void parse_args(int argc, char *argv[])
 {
+    server_config_set_defaults(&g_config);
+
+    // 設定ファイルを先に読み込み、他の引数で上書きできるようにする
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--config") == 0 || strcmp(argv[i], "-c") == 0) && i + 1 < argc)
+        {
+            if (!server_config_load_file(&g_config, argv[++i]))
+                exit(1);
+        }
+    }
+
     for (int i = 1; i < argc; i++)
     {
-        if ((strcmp(argv[i], "--port") == 0 || strcmp(argv[i], "-p") == 0) && i + 1 < argc)
+        const ConfigOption *option = find_config_option(argv[i]);
+
+        if (option && (option->flag_value || i + 1 < argc))
+        {
+            const char *value = option->flag_value ? option->flag_value : argv[++i];
+            if (!server_config_set_value(&g_config, option->key, value))
+            {
+                LOG_ERROR("不正な値: " << option->name << " " << value);
+                exit(1);
+            }
+        }
+        else if ((strcmp(argv[i], "--config") == 0 || strcmp(argv[i], "-c") == 0) && i + 1 < argc)
+        {
+            i++;
+        }
+        else if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
         {
-            g_port = atoi(argv[++i]);
+            g_headless.match_count = atoi(argv[++i]);
         }
-        else if (strcmp(argv[i], "--debug-log") == 0 || strcmp(argv[i], "-d") == 0)
+        else if (strcmp(argv[i], "--trace-record") == 0 && i + 1 < argc)
         {
-            g_debug_log_enabled = true;
+            g_headless.trace_record_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--trace-verify") == 0 && i + 1 < argc)
+        {
+            g_headless.trace_verify_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--packet-stream") == 0 && i + 1 < argc)
+        {
+            g_packet_stream_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--fuzz") == 0 && i + 1 < argc)
+        {
+            g_headless.fuzz_seed = (uint32_t)strtoul(argv[++i], nullptr, 0);
         }
         else if (strcmp(argv[i], "--help") == 0)
         {
-            printf("Usage: %s [options]\n", argv[0]);
-            printf("Options:\n");
-            printf("  --port, -p <port>  Server port (default: 5000)\n");
-            printf("  --debug-log, -d    Enable debug logging\n");
-            printf("  --help             Show this help\n");
+            print_usage(argv[0]);
             exit(0);
         }
     }
+
+    server_config_finalize(&g_config);
+    g_debug_log_enabled = g_config.debug_log;
 }
 
 // ポート番号を取得する関数
-int get_server_port() { return g_port; }
+int get_server_port() { return g_config.port; }
 
 // シグナルハンドラー
 void signal_handler(int signum)
@@ -52,6 +179,30 @@ void signal_handler(int signum)
         const char msg[] = "\nCtrl+C検出: サーバーを終了します...\n";
         write(STDERR_FILENO, msg, sizeof(msg) - 1);
         g_running = 0;
+        event_loop_wake(g_wake_fd);
+    }
+    else if (signum == SIGTERM)
+    {
+        if (g_drain_requested)
+        {
+            const char msg[] = "\nSIGTERM再受信: サーバーを終了します...\n";
+            write(STDERR_FILENO, msg, sizeof(msg) - 1);
+            g_running = 0;
+        }
+        else
+        {
+            const char msg[] = "\nSIGTERM受信: 進行中の試合の終了後に停止します...\n";
+            write(STDERR_FILENO, msg, sizeof(msg) - 1);
+            g_drain_requested = 1;
+        }
+        event_loop_wake(g_wake_fd);
+    }
+    else if (signum == SIGUSR2)
+    {
+        const char msg[] = "\nSIGUSR2受信: ホットリスタートします...\n";
+        write(STDERR_FILENO, msg, sizeof(msg) - 1);
+        g_restart_requested = 1;
+        event_loop_wake(g_wake_fd);
     }
 }
 
@@ -61,16 +212,53 @@ int main(int argc, char *argv[])
     // コマンドライン引数をパース
     parse_args(argc, argv);
 
-    printf("Starting server on port %d\n", g_port);
+    // ヘッドレス実行（ネットワークを初期化せずにAI同士の試合だけを回す）
+    if (g_headless.match_count > 0)
+        return headless_run_matches(&g_config, &g_headless);
+    if (g_packet_stream_path)
+        return headless_run_packet_stream(&g_config, g_packet_stream_path);
+
+    printf("Starting server on port %d\n", g_config.port);
 
-    // シグナルハンドラーを設定
+    // シグナルハンドラーを設定（ワーカーはfork後にこのハンドラーで受ける）
     signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    signal(SIGUSR2, signal_handler);
+
+    // ワーカーモード: 親プロセスは接続の受付と振り分けだけを行い、各ワーカーが独立したサーバーとして動く
+    WorkerStatus *worker_status = nullptr;
+    int worker_channel_fd = -1;
+    if (g_config.workers > 1)
+    {
+        WorkerRegistry *registry = worker_registry_create(g_config.workers);
+        if (!registry)
+            return 1;
+
+        int worker_index = worker_pool_spawn(registry, g_config.port, g_config.spectator_port, &worker_channel_fd);
+        if (worker_index == WORKER_SPAWN_FAILED)
+            return 1;
+        if (worker_index == WORKER_SUPERVISOR)
+            return worker_pool_supervise(registry);
+        worker_status = &registry->workers[worker_index];
+
+        // チェックポイント・管理ソケットはワーカーごとに別ファイルにする
+        if (g_config.checkpoint_path[0] != '\0')
+        {
+            size_t length = strlen(g_config.checkpoint_path);
+            snprintf(g_config.checkpoint_path + length, sizeof(g_config.checkpoint_path) - length, ".%d", worker_index);
+        }
+        if (g_config.admin_socket_path[0] != '\0')
+        {
+            size_t length = strlen(g_config.admin_socket_path);
+            snprintf(g_config.admin_socket_path + length, sizeof(g_config.admin_socket_path) - length, ".%d", worker_index);
+        }
+    }
 
     // サーバーコンテキスト初期化
     ServerContext ctx;
 
     // サーバー初期化（ポート番号を渡す）
-    if (!server_initialize(&ctx, g_port))
+    if (!server_initialize(&ctx, &g_config, worker_channel_fd))
     {
         LOG_ERROR("サーバー初期化失敗");
         return 1;
@@ -78,16 +266,25 @@ int main(int argc, char *argv[])
 
     // runningフラグを設定（server_initialize内のmemsetの後に設定する必要がある）
     ctx.running = &g_running;
+    ctx.drain_requested = &g_drain_requested;
+    ctx.restart_requested = &g_restart_requested;
+    ctx.worker_status = worker_status;
+    // ホットリスタートは単一プロセスのときだけ（ワーカーは同じポートに新サーバーを並べて入れ替える）
+    ctx.argv = worker_status ? nullptr : argv;
+    g_wake_fd = ctx.loop.wake_fd;
+
+    // 前のプロセスが試合中に落ちていれば、その試合から再開する
+    server_restore_checkpoint(&ctx);
 
     // メインループ（ゲーム終了後に再待機）
     while (g_running)
     {
-        // クライアント接続待機
-        if (!server_wait_for_clients(&ctx))
+        // クライアント接続待機（再開した試合は接続済みとして扱う）
+        if (!ctx.resumed_match && !server_wait_for_clients(&ctx))
         {
-            if (!g_running)
+            if (!g_running || ctx.draining)
             {
-                // Ctrl+C で中断された場合
+                // Ctrl+C で中断された場合、またはドレインで次の試合を始めない場合
                 break;
             }
             // エラーの場合は終了
@@ -96,7 +293,9 @@ int main(int argc, char *argv[])
         }
 
         // メインループ実行
+        worker_status_match_started(worker_status, count_connected_clients(ctx.players));
         server_run_main_loop(&ctx);
+        worker_status_match_finished(worker_status);
 
         // ゲーム終了後、Ctrl+C でなければリセットして再待機
         if (ctx.state.match_result_sent && ctx.state.phase == GAME_PHASE_GAME_FINISHED)
@@ -0,0 +1,65 @@
+#include "link_quality.h"
+#include <math.h>
+#include "../server_constants.h"
+
+void link_quality_init(LinkQuality *quality)
+{
+    quality->rtt_ms = 0.0f;
+    quality->jitter_ms = 0.0f;
+    quality->loss = 0.0f;
+    quality->has_rtt = false;
+    quality->sequence = 0;
+    quality->sent_ms = 0;
+    quality->awaiting = false;
+    quality->pings_sent = 0;
+    quality->pongs_received = 0;
+}
+
+bool link_quality_ping_due(const LinkQuality *quality, Uint32 now_ms)
+{
+    return quality->pings_sent == 0 || (int)(now_ms - quality->sent_ms) >= PING_INTERVAL_MS;
+}
+
+static void sample_loss(LinkQuality *quality, float lost)
+{
+    quality->loss += LINK_LOSS_EWMA_ALPHA * (lost - quality->loss);
+}
+
+PingPayload link_quality_on_ping_sent(LinkQuality *quality, Uint32 now_ms)
+{
+    // 次のpingまでに応答がなければ失われたとみなす
+    if (quality->awaiting)
+        sample_loss(quality, 1.0f);
+
+    quality->sequence++;
+    quality->sent_ms = now_ms;
+    quality->awaiting = true;
+    quality->pings_sent++;
+
+    PingPayload ping = { quality->sequence, now_ms };
+    return ping;
+}
+
+bool link_quality_on_pong(LinkQuality *quality, const PingPayload *pong, Uint32 now_ms)
+{
+    if (!quality->awaiting || pong->sequence != quality->sequence)
+        return false;
+
+    quality->awaiting = false;
+    quality->pongs_received++;
+    sample_loss(quality, 0.0f);
+
+    // 平滑化はRFC 6298のRTT推定と同じ形（jitterはRTTVARに相当）
+    float sample = (float)(now_ms - quality->sent_ms);
+    if (!quality->has_rtt)
+    {
+        quality->rtt_ms = sample;
+        quality->jitter_ms = sample * 0.5f;
+        quality->has_rtt = true;
+        return true;
+    }
+
+    quality->jitter_ms += LINK_JITTER_EWMA_ALPHA * (fabsf(quality->rtt_ms - sample) - quality->jitter_ms);
+    quality->rtt_ms += LINK_RTT_EWMA_ALPHA * (sample - quality->rtt_ms);
+    return true;
+}
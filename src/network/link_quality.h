@@ -0,0 +1,45 @@
+#ifndef LINK_QUALITY_H
+#define LINK_QUALITY_H
+
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+// PING / PONG のペイロード（クライアントは受け取った内容をそのまま PONG で返す）
+struct PingPayload
+{
+    uint32_t sequence;
+    Uint32 sent_ms;  // サーバーの送信時刻（クライアントは解釈しない）
+};
+
+// 接続品質の推定値（ping/pongごとに指数移動平均で更新）
+struct LinkQuality
+{
+    // 推定値
+    float rtt_ms;      // 平滑化したRTT
+    float jitter_ms;   // RTTのばらつき（平滑化RTTとの差の平均）
+    float loss;        // 応答のなかったpingの割合（0〜1）
+    bool has_rtt;      // 1回以上応答があった
+
+    // 送信中のping
+    uint32_t sequence;
+    Uint32 sent_ms;
+    bool awaiting;
+
+    uint32_t pings_sent;
+    uint32_t pongs_received;
+};
+
+// 新しい接続用に初期化
+void link_quality_init(LinkQuality *quality);
+
+// 次のpingを送る時刻か
+bool link_quality_ping_due(const LinkQuality *quality, Uint32 now_ms);
+
+// pingを送ったことを記録し、送るペイロードを返す
+// 前のpingに応答がなければ損失として数える
+PingPayload link_quality_on_ping_sent(LinkQuality *quality, Uint32 now_ms);
+
+// pongを受け取ったときに推定値を更新する（古いpingへの応答は無視してfalse）
+bool link_quality_on_pong(LinkQuality *quality, const PingPayload *pong, Uint32 now_ms);
+
+#endif
@@ -0,0 +1,260 @@
+#include "matchmaking.h"
+#include "../server_constants.h"
+
+static int rating_to_bucket(int rating)
+{
+    int bucket = rating / MATCHMAKING_BUCKET_WIDTH;
+    if (bucket < 0) return 0;
+    if (bucket >= MATCHMAKING_BUCKET_COUNT) return MATCHMAKING_BUCKET_COUNT - 1;
+    return bucket;
+}
+
+// bit lo〜hi（両端含む）が立ったマスク
+static uint64_t bucket_range_mask(int lo, int hi)
+{
+    if (lo > hi)
+        return 0;
+    uint64_t upper = (hi >= 63) ? ~0ULL : ((1ULL << (hi + 1)) - 1);
+    uint64_t lower = (1ULL << lo) - 1;
+    return upper & ~lower;
+}
+
+void matchmaking_init(MatchmakingQueue *queue)
+{
+    for (int i = 0; i < MATCHMAKING_MAX_ENTRIES; i++)
+    {
+        queue->entries[i].socket = nullptr;
+        queue->entries[i].age_next = (i + 1 < MATCHMAKING_MAX_ENTRIES) ? i + 1 : MATCHMAKING_NONE;
+    }
+    queue->free_head = 0;
+
+    for (int b = 0; b < MATCHMAKING_BUCKET_COUNT; b++)
+    {
+        queue->bucket_head[b] = MATCHMAKING_NONE;
+        queue->bucket_tail[b] = MATCHMAKING_NONE;
+    }
+    queue->occupied_buckets = 0;
+
+    queue->age_head = MATCHMAKING_NONE;
+    queue->age_tail = MATCHMAKING_NONE;
+    queue->rated_count = 0;
+    queue->unrated_head = MATCHMAKING_NONE;
+    queue->unrated_tail = MATCHMAKING_NONE;
+    queue->count = 0;
+}
+
+static void bucket_link(MatchmakingQueue *queue, int index)
+{
+    MatchmakingEntry *entry = &queue->entries[index];
+    int b = entry->bucket;
+
+    entry->bucket_prev = queue->bucket_tail[b];
+    entry->bucket_next = MATCHMAKING_NONE;
+    if (queue->bucket_tail[b] != MATCHMAKING_NONE)
+        queue->entries[queue->bucket_tail[b]].bucket_next = index;
+    else
+        queue->bucket_head[b] = index;
+    queue->bucket_tail[b] = index;
+    queue->occupied_buckets |= (1ULL << b);
+}
+
+static void bucket_unlink(MatchmakingQueue *queue, int index)
+{
+    MatchmakingEntry *entry = &queue->entries[index];
+    int b = entry->bucket;
+
+    if (entry->bucket_prev != MATCHMAKING_NONE)
+        queue->entries[entry->bucket_prev].bucket_next = entry->bucket_next;
+    else
+        queue->bucket_head[b] = entry->bucket_next;
+
+    if (entry->bucket_next != MATCHMAKING_NONE)
+        queue->entries[entry->bucket_next].bucket_prev = entry->bucket_prev;
+    else
+        queue->bucket_tail[b] = entry->bucket_prev;
+
+    if (queue->bucket_head[b] == MATCHMAKING_NONE)
+        queue->occupied_buckets &= ~(1ULL << b);
+}
+
+// 待機順リスト（確定済みか未確定）の末尾へつなぐ
+static void list_append(MatchmakingQueue *queue, int *head, int *tail, int index)
+{
+    MatchmakingEntry *entry = &queue->entries[index];
+    entry->age_prev = *tail;
+    entry->age_next = MATCHMAKING_NONE;
+    if (*tail != MATCHMAKING_NONE)
+        queue->entries[*tail].age_next = index;
+    else
+        *head = index;
+    *tail = index;
+}
+
+static void list_unlink(MatchmakingQueue *queue, int *head, int *tail, int index)
+{
+    MatchmakingEntry *entry = &queue->entries[index];
+    if (entry->age_prev != MATCHMAKING_NONE)
+        queue->entries[entry->age_prev].age_next = entry->age_next;
+    else
+        *head = entry->age_next;
+
+    if (entry->age_next != MATCHMAKING_NONE)
+        queue->entries[entry->age_next].age_prev = entry->age_prev;
+    else
+        *tail = entry->age_prev;
+}
+
+bool matchmaking_enqueue(MatchmakingQueue *queue, TCPsocket socket, Uint32 now_ms)
+{
+    int index = queue->free_head;
+    if (index == MATCHMAKING_NONE)
+        return false;
+
+    MatchmakingEntry *entry = &queue->entries[index];
+    queue->free_head = entry->age_next;
+
+    entry->socket = socket;
+    entry->rating = 0;
+    entry->rated = false;
+    entry->enqueued_ms = now_ms;
+    entry->bucket = MATCHMAKING_NONE;
+    list_append(queue, &queue->unrated_head, &queue->unrated_tail, index);
+
+    queue->count++;
+    return true;
+}
+
+void matchmaking_remove(MatchmakingQueue *queue, int index)
+{
+    MatchmakingEntry *entry = &queue->entries[index];
+    if (!entry->socket)
+        return;
+
+    if (entry->rated)
+    {
+        bucket_unlink(queue, index);
+        list_unlink(queue, &queue->age_head, &queue->age_tail, index);
+        queue->rated_count--;
+    }
+    else
+    {
+        list_unlink(queue, &queue->unrated_head, &queue->unrated_tail, index);
+    }
+
+    entry->socket = nullptr;
+    entry->age_next = queue->free_head;
+    queue->free_head = index;
+    queue->count--;
+}
+
+void matchmaking_set_rating(MatchmakingQueue *queue, int index, int rating)
+{
+    MatchmakingEntry *entry = &queue->entries[index];
+    if (!entry->socket)
+        return;
+
+    if (entry->rated)
+    {
+        bucket_unlink(queue, index);
+    }
+    else
+    {
+        list_unlink(queue, &queue->unrated_head, &queue->unrated_tail, index);
+        list_append(queue, &queue->age_head, &queue->age_tail, index);
+        entry->rated = true;
+        queue->rated_count++;
+    }
+
+    entry->rating = rating;
+    entry->bucket = rating_to_bucket(rating);
+    bucket_link(queue, index);
+}
+
+int matchmaking_oldest_unrated(const MatchmakingQueue *queue)
+{
+    return queue->unrated_head;
+}
+
+// 待ち時間から探索範囲（バケット数）を決める
+static int search_window(Uint32 wait_ms)
+{
+    if ((int)wait_ms >= MATCHMAKING_MAX_WAIT_MS)
+        return MATCHMAKING_BUCKET_COUNT;
+    return MATCHMAKING_INITIAL_WINDOW_BUCKETS + (int)wait_ms / MATCHMAKING_WIDEN_INTERVAL_MS;
+}
+
+// entryの範囲内で最もレーティングの近い相手を探す
+static int find_partner(const MatchmakingQueue *queue, int index, int window)
+{
+    const MatchmakingEntry *entry = &queue->entries[index];
+    int b = entry->bucket;
+
+    // 同じ帯に他の待機者がいればその中で最も古い人
+    int same = queue->bucket_head[b];
+    if (same == index)
+        same = entry->bucket_next;
+    if (same != MATCHMAKING_NONE)
+        return same;
+
+    int lo = (b - window < 0) ? 0 : b - window;
+    int hi = (b + window >= MATCHMAKING_BUCKET_COUNT) ? MATCHMAKING_BUCKET_COUNT - 1 : b + window;
+
+    uint64_t below = queue->occupied_buckets & bucket_range_mask(lo, b - 1);
+    uint64_t above = queue->occupied_buckets & bucket_range_mask(b + 1, hi);
+
+    int below_bucket = below ? 63 - __builtin_clzll(below) : MATCHMAKING_NONE;
+    int above_bucket = above ? __builtin_ctzll(above) : MATCHMAKING_NONE;
+
+    if (below_bucket == MATCHMAKING_NONE && above_bucket == MATCHMAKING_NONE)
+        return MATCHMAKING_NONE;
+    if (below_bucket == MATCHMAKING_NONE)
+        return queue->bucket_head[above_bucket];
+    if (above_bucket == MATCHMAKING_NONE)
+        return queue->bucket_head[below_bucket];
+
+    // 両側に候補があれば近い方、同じ距離なら長く待っている方
+    int below_dist = b - below_bucket;
+    int above_dist = above_bucket - b;
+    if (below_dist != above_dist)
+        return (below_dist < above_dist) ? queue->bucket_head[below_bucket] : queue->bucket_head[above_bucket];
+
+    int below_head = queue->bucket_head[below_bucket];
+    int above_head = queue->bucket_head[above_bucket];
+    return (queue->entries[below_head].enqueued_ms <= queue->entries[above_head].enqueued_ms) ? below_head : above_head;
+}
+
+bool matchmaking_find_pair(MatchmakingQueue *queue, Uint32 now_ms, TCPsocket *first, TCPsocket *second)
+{
+    if (queue->rated_count < 2)
+        return false;
+
+    // 長く待っている人から順に、一定人数だけ相手を探す
+    int index = queue->age_head;
+    for (int scanned = 0; index != MATCHMAKING_NONE && scanned < MATCHMAKING_SCAN_LIMIT; scanned++)
+    {
+        const MatchmakingEntry *entry = &queue->entries[index];
+        int partner = find_partner(queue, index, search_window(now_ms - entry->enqueued_ms));
+
+        if (partner != MATCHMAKING_NONE)
+        {
+            *first = entry->socket;
+            *second = queue->entries[partner].socket;
+            matchmaking_remove(queue, index);
+            matchmaking_remove(queue, partner);
+            return true;
+        }
+        index = entry->age_next;
+    }
+    return false;
+}
+
+TCPsocket matchmaking_pop_oldest(MatchmakingQueue *queue)
+{
+    int index = queue->age_head;
+    if (index == MATCHMAKING_NONE)
+        return nullptr;
+
+    TCPsocket socket = queue->entries[index].socket;
+    matchmaking_remove(queue, index);
+    return socket;
+}
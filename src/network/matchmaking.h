@@ -0,0 +1,75 @@
+#ifndef MATCHMAKING_H
+#define MATCHMAKING_H
+
+#include <stdint.h>
+#include <SDL2/SDL_net.h>
+
+#define MATCHMAKING_MAX_ENTRIES 1024
+#define MATCHMAKING_BUCKET_COUNT 64   // 空きバケット検索を64bitマスク1語で行うため64固定
+#define MATCHMAKING_NONE (-1)
+
+// 待機中の接続1件
+struct MatchmakingEntry
+{
+    TCPsocket socket;
+    int rating;
+    bool rated;       // false: レーティング未確定（バケットに入れず、組み合わせの対象にしない）
+    Uint32 enqueued_ms;
+    int bucket;
+
+    // 同じレーティング帯のリスト（古い順）
+    int bucket_prev;
+    int bucket_next;
+
+    // 待機順リスト（古い順、未確定・確定済み・空きエントリのいずれか1つに属する）
+    int age_prev;
+    int age_next;
+};
+
+// レーティング帯ごとに索引付けしたマッチング待ち行列
+// 追加・削除・対戦相手の検索はいずれもエントリ数に依らず一定時間
+// 接続直後はレーティング未確定の列に入り、確定した時点で確定済みの列の末尾とバケットへ移る
+struct MatchmakingQueue
+{
+    MatchmakingEntry entries[MATCHMAKING_MAX_ENTRIES];
+    int free_head;
+
+    int bucket_head[MATCHMAKING_BUCKET_COUNT];
+    int bucket_tail[MATCHMAKING_BUCKET_COUNT];
+    uint64_t occupied_buckets;  // bit i: バケットiに待機者がいる
+
+    // 確定済み（確定した順）
+    int age_head;
+    int age_tail;
+    int rated_count;
+
+    // 未確定（接続した順）
+    int unrated_head;
+    int unrated_tail;
+
+    int count;  // 未確定を含む全体
+};
+
+// 初期化
+void matchmaking_init(MatchmakingQueue *queue);
+
+// レーティング未確定として待機列に追加（満杯ならfalse）
+bool matchmaking_enqueue(MatchmakingQueue *queue, TCPsocket socket, Uint32 now_ms);
+
+// 待機列から外す（ソケットは閉じない）
+void matchmaking_remove(MatchmakingQueue *queue, int index);
+
+// レーティングを確定・更新する（待機時間は維持する）
+void matchmaking_set_rating(MatchmakingQueue *queue, int index, int rating);
+
+// レーティング未確定のうち最も古いもの（なければMATCHMAKING_NONE）
+int matchmaking_oldest_unrated(const MatchmakingQueue *queue);
+
+// 待ち時間に応じて許容範囲を広げながら、レーティング確定済みの中から対戦ペアを探す
+// 見つかった2件は待機列から外して返す
+bool matchmaking_find_pair(MatchmakingQueue *queue, Uint32 now_ms, TCPsocket *first, TCPsocket *second);
+
+// レーティング確定済みのうち最も長く待っている1件を取り出す（いなければNULL）
+TCPsocket matchmaking_pop_oldest(MatchmakingQueue *queue);
+
+#endif
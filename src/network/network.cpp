@@ -3,7 +3,18 @@
 #include "../server_constants.h"
 
 #include <SDL2/SDL_net.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/sockios.h>
+#include <type_traits>
 
 #include "common/player_id.h"
 #include "common/ball.h"
@@ -12,6 +23,8 @@
 
 extern volatile int g_running;
 
+static bool socket_layout_matches(TCPsocket listener, int port);
+
 TCPsocket network_init_server(int port)
 {
     if (SDLNet_Init() < 0)
@@ -20,6 +33,14 @@ TCPsocket network_init_server(int port)
         return nullptr;
     }
 
+    // ホットリスタートで起動された場合は旧プロセスのリスナーをそのまま使う
+    TCPsocket inherited = network_adopt_listen_socket(LISTEN_FD_ENV);
+    if (inherited)
+    {
+        LOG_SUCCESS("サーバー起動: 引き継いだリスナーを使用 (ポート " << port << ")");
+        return inherited;
+    }
+
     IPaddress ip;
     if (SDLNet_ResolveHost(&ip, nullptr, port) < 0)
     {
@@ -34,6 +55,13 @@ TCPsocket network_init_server(int port)
         return nullptr;
     }
 
+    if (!socket_layout_matches(server, port))
+    {
+        LOG_ERROR("SDL_netのソケット内部構造が想定と異なる（SDL_netの版を確認すること）");
+        SDLNet_TCP_Close(server);
+        return nullptr;
+    }
+
     LOG_SUCCESS("サーバー起動: ポート " << port);
     return server;
 }
@@ -44,22 +72,39 @@ TCPsocket network_accept_client(TCPsocket server_socket, Player players[], Clien
     if (!client)
         return nullptr;
 
-    for (int i = 0; i < MAX_CLIENTS; i++)
+    if (network_assign_client(client, players, connections, REQUIRED_CLIENTS) >= 0)
+        return client;
+
+    LOG_WARN("サーバー満員");
+    SDLNet_TCP_Close(client);
+    return nullptr;
+}
+
+int network_assign_client(TCPsocket client, Player players[], ClientConnection connections[], int slot_count)
+{
+    for (int i = 0; i < slot_count && i < MAX_CLIENTS; i++)
     {
         if (!players[i].connected)
         {
             connections[i].socket = client;
             connections[i].player_id = i;
+            rate_limiter_init(&connections[i].input_limiter, CLIENT_PACKET_RATE_PER_SEC, CLIENT_PACKET_BURST, SDL_GetTicks());
+            input_validator_init(&connections[i].input_validator, SDL_GetTicks());
+            connections[i].packets_received = 0;
+            connections[i].packets_deferred_ticks = 0;
+            connections[i].reported_deferred_ticks = 0;
+            connections[i].input_deferred = false;
+            connections[i].last_input_sequence = 0;
+            link_quality_init(&connections[i].link_quality);
+            snapshot_pacer_init(&connections[i].snapshot_pacer);
+            connections[i].send_tail_length = 0;
             players[i].connected = true;
             players[i].player_id = i;
             LOG_SUCCESS("クライアント接続 (スロット " << i << ")");
-            return client;
+            return i;
         }
     }
-
-    LOG_WARN("サーバー満員");
-    SDLNet_TCP_Close(client);
-    return nullptr;
+    return -1;
 }
 
 void wait_for_clients(TCPsocket server_socket, Player players[], ClientConnection connections[])
@@ -115,6 +160,70 @@ int network_send_packet(TCPsocket client_socket, const Packet *packet)
     return sizeof(Packet);
 }
 
+// 送り残しを送る（blocking: 送り切るまで待つ）
+static bool flush_send_tail(ClientConnection *connection, bool blocking)
+{
+    if (connection->send_tail_length == 0)
+        return true;
+
+    if (blocking)
+    {
+        int length = connection->send_tail_length;
+        connection->send_tail_length = 0;
+        return SDLNet_TCP_Send(connection->socket, connection->send_tail, length) == length;
+    }
+
+    int fd = network_get_socket_fd(connection->socket);
+    ssize_t sent = send(fd, connection->send_tail, connection->send_tail_length, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent <= 0)
+        return false;
+
+    connection->send_tail_length -= (int)sent;
+    memmove(connection->send_tail, connection->send_tail + sent, connection->send_tail_length);
+    return connection->send_tail_length == 0;
+}
+
+int network_send_packet_to(ClientConnection *connection, const Packet *packet)
+{
+    if (!validate_network_params(packet, connection->socket))
+        return -1;
+
+    // パケットの途中に別のパケットを挟まないよう、残りを先に送る
+    if (!flush_send_tail(connection, true))
+    {
+        LOG_ERROR("送信失敗: " << SDLNet_GetError());
+        return 0;
+    }
+    return network_send_packet(connection->socket, packet);
+}
+
+NetworkTrySendResult network_try_send_packet(ClientConnection *connection, const Packet *packet)
+{
+    if (!validate_network_params(packet, connection->socket))
+        return NETWORK_SEND_ERROR;
+
+    if (!flush_send_tail(connection, false))
+        return NETWORK_SEND_SKIPPED;
+
+    int fd = network_get_socket_fd(connection->socket);
+    ssize_t sent = send(fd, packet, sizeof(Packet), MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent == (ssize_t)sizeof(Packet))
+        return NETWORK_SEND_OK;
+
+    if (sent < 0)
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? NETWORK_SEND_SKIPPED : NETWORK_SEND_ERROR;
+
+    // 途中まで送ったパケットは捨てられないので、残りを次の送信の前に送る
+    connection->send_tail_length = (int)(sizeof(Packet) - sent);
+    memcpy(connection->send_tail, (const uint8_t *)packet + sent, connection->send_tail_length);
+    return NETWORK_SEND_PARTIAL;
+}
+
+void network_clear_send_tail(ClientConnection *connection)
+{
+    connection->send_tail_length = 0;
+}
+
 int network_receive(TCPsocket client_socket, void *buffer, int size)
 {
     int total_received = 0;
@@ -160,19 +269,58 @@ int network_receive_packet(TCPsocket client_socket, Packet *packet)
         return -1;
     }
 
-    if (packet->type >= PACKET_TYPE_MAX)
-    {
-        LOG_WARN("不正なパケットタイプ: " << (int)packet->type);
+    if (!network_validate_packet(packet))
         return -1;
+
+    return received_size;
+}
+
+NetworkTryReceiveResult network_try_receive_packet(TCPsocket client_socket, Packet *packet)
+{
+    int fd = network_get_socket_fd(client_socket);
+    if (!packet || fd < 0)
+        return NETWORK_RECEIVE_ERROR;
+
+    // 途中まで読むと残りを待つ間ブロックするので、そろうまではカーネルバッファに残しておく
+    memset(packet, 0, sizeof(Packet));
+    ssize_t received = recv(fd, packet, sizeof(Packet), MSG_PEEK | MSG_DONTWAIT);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return NETWORK_RECEIVE_PENDING;
+    if (received <= 0)
+        return NETWORK_RECEIVE_ERROR;
+    if (received < (ssize_t)sizeof(Packet))
+        return NETWORK_RECEIVE_PENDING;
+
+    if (recv(fd, packet, sizeof(Packet), MSG_DONTWAIT) != (ssize_t)sizeof(Packet) || !network_validate_packet(packet))
+        return NETWORK_RECEIVE_ERROR;
+    return NETWORK_RECEIVE_OK;
+}
+
+long long network_packet_raw_type(const Packet *packet)
+{
+    typedef decltype(Packet::type) TypeField;
+    typedef typename std::conditional<std::is_enum<TypeField>::value, std::underlying_type<TypeField>,
+                                      std::common_type<TypeField>>::type::type RawType;
+    RawType raw_type;
+    memcpy(&raw_type, (const unsigned char *)packet + offsetof(Packet, type), sizeof(raw_type));
+    return (long long)raw_type;
+}
+
+bool network_validate_packet(const Packet *packet)
+{
+    long long raw_type = network_packet_raw_type(packet);
+    if (raw_type < 0 || raw_type >= PACKET_TYPE_SERVER_MAX)
+    {
+        LOG_WARN("不正なパケットタイプ: " << raw_type);
+        return false;
     }
 
     if (packet->size > PACKET_MAX_SIZE)
     {
         LOG_WARN("不正なパケットサイズ: " << packet->size);
-        return -1;
+        return false;
     }
-
-    return received_size;
+    return true;
 }
 
 void network_close_client(Player *player, ClientConnection *connection)
@@ -207,15 +355,15 @@ void network_broadcast(Player players[], ClientConnection connections[], const P
     for (int i = 0; i < MAX_CLIENTS; i++)
     {
         if (players[i].connected && connections[i].socket)
-            network_send_packet(connections[i].socket, packet);
+            network_send_packet_to(&connections[i], packet);
     }
 }
 
-static Packet create_packet_with_data(PacketType type, const void *data, size_t data_size)
+static Packet create_packet_with_data(int type, const void *data, size_t data_size)
 {
     Packet packet;
     memset(&packet, 0, sizeof(Packet));
-    packet.type = type;
+    packet.type = (PacketType)type;
     packet.size = data_size;
     if (data && data_size > 0)
         memcpy(packet.data, data, data_size);
@@ -258,6 +406,47 @@ Packet create_packet_match_result(int winner_id)
     return create_packet_with_data(PACKET_TYPE_MATCH_RESULT, &winner_id, sizeof(int));
 }
 
+Packet create_packet_session_token(int player_id, uint64_t token)
+{
+    SessionToken session = { player_id, token };
+    return create_packet_with_data(PACKET_TYPE_SESSION_TOKEN, &session, sizeof(SessionToken));
+}
+
+Packet create_packet_extra_balls(const Ball balls[], const int owner_ids[], int count)
+{
+    ExtraBallsState payload;
+    memset(&payload, 0, sizeof(payload));
+    payload.count = (count < 0) ? 0 : (count > MAX_BALLS - 1) ? MAX_BALLS - 1 : count;
+    for (int i = 0; i < payload.count; i++)
+    {
+        payload.owner_id[i] = owner_ids[i];
+        payload.balls[i] = balls[i];
+    }
+    return create_packet_with_data(PACKET_TYPE_EXTRA_BALLS, &payload, sizeof(payload));
+}
+
+Packet create_packet_score_detail(const ScoreDetailState *detail)
+{
+    return create_packet_with_data(PACKET_TYPE_SCORE_DETAIL, detail, sizeof(ScoreDetailState));
+}
+
+Packet create_packet_ping(const PingPayload *ping)
+{
+    return create_packet_with_data(PACKET_TYPE_PING, ping, sizeof(PingPayload));
+}
+
+void network_stamp_state(Packet *packet, const StateStamp *stamp)
+{
+    memcpy(packet->data + STATE_STAMP_OFFSET, stamp, sizeof(StateStamp));
+}
+
+uint32_t network_input_sequence(const Packet *packet)
+{
+    InputStamp stamp;
+    memcpy(&stamp, packet->data + INPUT_STAMP_OFFSET, sizeof(InputStamp));
+    return stamp.sequence;
+}
+
 int count_connected_clients(const Player players[])
 {
     int count = 0;
@@ -268,3 +457,316 @@ int count_connected_clients(const Player players[])
     }
     return count;
 }
+
+// SDL_netのTCPsocket内部構造（SDL_net 2.x の struct _TCPsocket と同じ並び）
+// SDL_netはディスクリプタを公開していないため、構造を写して参照・生成する
+// 並びを確認した版（2.0.0〜2.2.x）以外ではビルドを止める。版を上げるときは SDLnetTCP.c の定義と見比べてから範囲を広げる
+static_assert(SDL_NET_MAJOR_VERSION == 2 && SDL_NET_MINOR_VERSION <= 2,
+              "SDLNetTCPSocketLayout must be checked against struct _TCPsocket of this SDL_net version");
+
+struct SDLNetTCPSocketLayout
+{
+    int ready;
+    int channel;
+    IPaddress remote_address;
+    IPaddress local_address;
+    int sflag;  // 1: リスナー（SDLNet_TCP_Accept が確認する）
+};
+
+int network_get_socket_fd(TCPsocket socket)
+{
+    if (!socket)
+        return -1;
+    return ((const SDLNetTCPSocketLayout *)socket)->channel;
+}
+
+// SDL_netが開いたリスナーから読んだディスクリプタが、実際にそのポートで待ち受けているTCPソケットか
+// （版の確認をすり抜けて構造が食い違っていた場合に、起動時に気づけるようにする）
+static bool socket_layout_matches(TCPsocket listener, int port)
+{
+    int fd = network_get_socket_fd(listener);
+    if (fd < 0)
+        return false;
+
+    int type = 0;
+    socklen_t type_length = sizeof(type);
+    struct sockaddr_in addr;
+    socklen_t addr_length = sizeof(addr);
+    return getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &type_length) == 0 && type == SOCK_STREAM &&
+           getsockname(fd, (struct sockaddr *)&addr, &addr_length) == 0 && addr.sin_family == AF_INET &&
+           ntohs(addr.sin_port) == port;
+}
+
+int network_pending_bytes(TCPsocket socket)
+{
+    int fd = network_get_socket_fd(socket);
+    if (fd < 0)
+        return 0;
+
+    int pending = 0;
+    if (ioctl(fd, FIONREAD, &pending) < 0)
+        return 0;
+    return pending;
+}
+
+int network_send_queue_bytes(TCPsocket socket)
+{
+    int fd = network_get_socket_fd(socket);
+    if (fd < 0)
+        return -1;
+
+    int queued = 0;
+    if (ioctl(fd, SIOCOUTQ, &queued) < 0)
+        return -1;
+    return queued;
+}
+
+// ディスクリプタをSDL_netのTCPsocketとして包む（SDLNet_TCP_Close で閉じられるようにする）
+static TCPsocket wrap_fd(int fd, bool listener)
+{
+    // SDLNet_TCP_Close が SDL_free で解放するため SDL_malloc で確保する
+    SDLNetTCPSocketLayout *layout = (SDLNetTCPSocketLayout *)SDL_malloc(sizeof(SDLNetTCPSocketLayout));
+    if (!layout)
+        return nullptr;
+
+    memset(layout, 0, sizeof(SDLNetTCPSocketLayout));
+    layout->channel = fd;
+    layout->sflag = listener ? 1 : 0;
+    return (TCPsocket)layout;
+}
+
+// リスナーのディスクリプタをSDL_netのTCPsocketとして包む
+static TCPsocket wrap_listen_fd(int fd)
+{
+    // SDL_netのリスナーと同じく非ブロッキングにしておく
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return wrap_fd(fd, true);
+}
+
+// 受け取ったクライアントのディスクリプタを、SDLNet_TCP_Accept が返すものと同じ形で包む
+static TCPsocket wrap_client_fd(int fd)
+{
+    // 送り側（受付プロセス）は非ブロッキングで受け付けるが、SDLNet_TCP_Accept の戻り値はブロッキング
+    // ID・SESSION_TOKEN などを SDLNet_TCP_Send で送る処理はそれを前提にしているので合わせる
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) < 0)
+        return nullptr;
+
+    TCPsocket socket = wrap_fd(fd, false);
+    if (!socket)
+        return nullptr;
+
+    // IPaddress はSDL_netと同じくネットワークバイトオーダーで持つ
+    SDLNetTCPSocketLayout *layout = (SDLNetTCPSocketLayout *)socket;
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    if (getpeername(fd, (struct sockaddr *)&addr, &length) == 0 && addr.sin_family == AF_INET)
+    {
+        layout->remote_address.host = addr.sin_addr.s_addr;
+        layout->remote_address.port = addr.sin_port;
+    }
+    length = sizeof(addr);
+    if (getsockname(fd, (struct sockaddr *)&addr, &length) == 0 && addr.sin_family == AF_INET)
+    {
+        layout->local_address.host = addr.sin_addr.s_addr;
+        layout->local_address.port = addr.sin_port;
+    }
+    return socket;
+}
+
+TCPsocket network_adopt_listen_socket(const char *env_name)
+{
+    const char *value = getenv(env_name);
+    if (!value)
+        return nullptr;
+
+    int fd = atoi(value);
+    unsetenv(env_name);
+
+    if (fd < 0 || fcntl(fd, F_GETFD) < 0)
+    {
+        LOG_WARN("引き継ぎリスナーが無効: " << env_name << "=" << fd);
+        return nullptr;
+    }
+    return wrap_listen_fd(fd);
+}
+
+TCPsocket network_open_reuseport_listener(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        LOG_ERROR("ソケット作成失敗: " << strerror(errno));
+        return nullptr;
+    }
+
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) < 0)
+    {
+        LOG_ERROR("SO_REUSEPORT設定失敗: " << strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0)
+    {
+        LOG_ERROR("ポート " << port << " の待ち受け失敗: " << strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+
+    TCPsocket listener = wrap_listen_fd(fd);
+    if (!listener)
+        close(fd);
+    return listener;
+}
+
+bool network_open_fd_channel(TCPsocket *local, TCPsocket *remote)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0)
+    {
+        LOG_ERROR("ディスクリプタ受け渡し用のソケット作成失敗: " << strerror(errno));
+        return false;
+    }
+
+    *local = wrap_fd(fds[0], false);
+    *remote = wrap_fd(fds[1], false);
+    if (!*local || !*remote)
+    {
+        if (*local) SDLNet_TCP_Close(*local); else close(fds[0]);
+        if (*remote) SDLNet_TCP_Close(*remote); else close(fds[1]);
+        *local = nullptr;
+        *remote = nullptr;
+        return false;
+    }
+    return true;
+}
+
+TCPsocket network_wrap_fd_channel(int fd)
+{
+    if (fd < 0 || fcntl(fd, F_GETFD) < 0)
+        return nullptr;
+
+    // 引き継ぎ用に外したCLOEXECを戻す（さらに次のプロセスへは漏らさない）
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return wrap_fd(fd, false);
+}
+
+TCPsocket network_adopt_fd_channel(const char *env_name)
+{
+    const char *value = getenv(env_name);
+    if (!value)
+        return nullptr;
+
+    int fd = atoi(value);
+    unsetenv(env_name);
+
+    TCPsocket channel = network_wrap_fd_channel(fd);
+    if (!channel)
+        LOG_WARN("引き継いだ受け渡し経路が無効: " << env_name << "=" << fd);
+    return channel;
+}
+
+bool network_send_fd(TCPsocket channel, int fd, const void *data, size_t size)
+{
+    int channel_fd = network_get_socket_fd(channel);
+    if (channel_fd < 0 || fd < 0)
+        return false;
+
+    struct iovec iov;
+    iov.iov_base = (void *)data;
+    iov.iov_len = size;
+
+    union
+    {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    return sendmsg(channel_fd, &message, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)size;
+}
+
+int network_receive_fd(TCPsocket channel, TCPsocket *client, void *data, size_t size)
+{
+    int channel_fd = network_get_socket_fd(channel);
+    if (channel_fd < 0)
+        return -1;
+
+    // ディスクリプタのない・中身の欠けたメッセージは捨てて次を読む
+    for (;;)
+    {
+        struct iovec iov;
+        iov.iov_base = data;
+        iov.iov_len = size;
+
+        union
+        {
+            char buffer[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+
+        struct msghdr message = {};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+
+        ssize_t received = recvmsg(channel_fd, &message, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+        if (received < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            {
+                // 読み切ったので、次の通知までは準備完了の印を外す
+                ((SDLNetTCPSocketLayout *)channel)->ready = 0;
+                return 0;
+            }
+            return -1;
+        }
+        if (received == 0)
+            return -1;
+
+        int fd = -1;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN(sizeof(int)))
+                memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+
+        if (fd < 0 || received != (ssize_t)size || (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)))
+        {
+            if (fd >= 0)
+                close(fd);
+            continue;
+        }
+
+        *client = wrap_client_fd(fd);
+        if (!*client)
+        {
+            close(fd);
+            continue;
+        }
+        return 1;
+    }
+}
@@ -9,30 +9,173 @@
 #include "common/GameScore.h"
 #include "common/GamePhase.h"
 #include "common/ability.h"
+#include "common/player_input.h"
+#include "common/player_swing.h"
+#include "rate_limiter.h"
+#include "link_quality.h"
+#include "snapshot_pacer.h"
+#include "input_handler/input_validator.h"
 
-#define MAX_CLIENTS 2
-#define REQUIRED_CLIENTS 2
+#define MAX_CLIENTS 4       // ダブルス（2対2）まで
+#define REQUIRED_CLIENTS 2  // シングルスの人数
+#define TEAM_COUNT 2
+#define MAX_BALLS 4  // 1試合で同時に存在できるボール（本球 + 分身）
 #define SERVER_PORT 5000
 
+// ホットリスタート時にリスナーのディスクリプタを新プロセスへ渡す環境変数
+#define LISTEN_FD_ENV "POT_LISTEN_FD"
+#define SPECTATOR_LISTEN_FD_ENV "POT_SPECTATOR_LISTEN_FD"
+// 新プロセスが受けた再接続を旧プロセスへ渡すための経路
+#define RESUME_FORWARD_FD_ENV "POT_RESUME_FORWARD_FD"
+// 新プロセスがリスナーを開き終えたことを旧プロセスへ知らせる経路
+#define RESTART_READY_FD_ENV "POT_RESTART_READY_FD"
+
+// サーバー拡張パケットタイプ（commonのPacketTypeの後ろに続ける）
+enum ServerPacketType {
+    PACKET_TYPE_SESSION_TOKEN = PACKET_TYPE_MAX,  // サーバー→クライアント: セッショントークン発行
+    PACKET_TYPE_SESSION_RESUME,                   // クライアント→サーバー: 再接続要求
+    PACKET_TYPE_MATCHMAKING_JOIN,                 // クライアント→サーバー: マッチング用レーティング通知
+    PACKET_TYPE_EXTRA_BALLS,                      // サーバー→クライアント: 本球以外のボール一式
+    PACKET_TYPE_SCORE_DETAIL,                     // サーバー→クライアント: ゲーム数・タイブレークを含むスコア
+    PACKET_TYPE_PING,                             // サーバー→クライアント: 接続品質の計測
+    PACKET_TYPE_PONG,                             // クライアント→サーバー: 受け取ったPINGのペイロードをそのまま返す
+    PACKET_TYPE_SERVER_MAX
+};
+
+// セッショントークン（SESSION_TOKEN / SESSION_RESUME のペイロード）
+struct SessionToken
+{
+    int player_id;
+    uint64_t token;
+};
+
+// マッチング参加情報（MATCHMAKING_JOIN のペイロード）
+struct MatchmakingJoin
+{
+    int rating;
+};
+
+// 本球以外のボール（EXTRA_BALLS のペイロード、count == 0 で全消去）
+// 本球は従来どおり BALL_STATE で送る
+struct ExtraBallsState
+{
+    int count;
+    int owner_id[MAX_BALLS - 1];
+    Ball balls[MAX_BALLS - 1];
+};
+static_assert(sizeof(ExtraBallsState) <= PACKET_MAX_SIZE, "ExtraBallsState must fit in one packet");
+
+// ゲーム数・タイブレークを含むスコア（SCORE_DETAIL のペイロード）
+// ポイントとセット数は従来どおり SCORE_UPDATE で送る
+struct ScoreDetailState
+{
+    int games[2];
+    int sets[2];
+    int tiebreak_points[2];
+    int tiebreak_target;   // 0: タイブレーク中でない
+    int sets_to_win;
+    uint32_t events;       // 前回送信以降に起きた ScoreEvent
+};
+
+// 状態パケットの末尾スタンプ（クライアント側予測の照合用）
+// data の末尾の固定位置に置き、size には含めない（従来のクライアントは読まずに無視する）
+struct StateStamp
+{
+    uint32_t server_tick;              // このパケットを作ったシミュレーションtick
+    uint32_t input_ack[MAX_CLIENTS];   // プレイヤーごとに最後に処理した入力の通し番号（0: なし）
+};
+#define STATE_STAMP_OFFSET (PACKET_MAX_SIZE - sizeof(StateStamp))
+static_assert(sizeof(Player) <= STATE_STAMP_OFFSET, "Player must leave room for StateStamp");
+static_assert(sizeof(Ball) <= STATE_STAMP_OFFSET, "Ball must leave room for StateStamp");
+static_assert(sizeof(ExtraBallsState) <= STATE_STAMP_OFFSET, "ExtraBallsState must leave room for StateStamp");
+static_assert(sizeof(ScoreDetailState) <= STATE_STAMP_OFFSET, "ScoreDetailState must leave room for StateStamp");
+static_assert(sizeof(GameScore) <= STATE_STAMP_OFFSET, "GameScore must leave room for StateStamp");
+static_assert(sizeof(AbilityState) <= STATE_STAMP_OFFSET, "AbilityState must leave room for StateStamp");
+
+// クライアント入力の末尾スタンプ（PLAYER_INPUT / PLAYER_SWING の data 末尾、0: 番号なし）
+struct InputStamp
+{
+    uint32_t sequence;
+};
+#define INPUT_STAMP_OFFSET (PACKET_MAX_SIZE - sizeof(InputStamp))
+static_assert(sizeof(PlayerInput) <= INPUT_STAMP_OFFSET, "PlayerInput must leave room for InputStamp");
+static_assert(sizeof(PlayerSwing) <= INPUT_STAMP_OFFSET, "PlayerSwing must leave room for InputStamp");
+
 // サーバー専用のソケット管理構造体
 struct ClientConnection
 {
     TCPsocket socket;
     int player_id;  // playersインデックスと対応
+
+    // 再接続用セッション
+    uint64_t session_token;   // 0: 未発行
+    bool suspended;           // 切断中（猶予期間内、スロットは保持）
+    Uint32 suspended_at_ms;
+
+    // 受信レート制限と統計
+    RateLimiter input_limiter;
+    InputValidator input_validator;  // 移動速度・スイングの妥当性
+    uint32_t packets_received;
+    uint32_t packets_deferred_ticks;  // 上限超過で読み残したtick数（累計）
+    uint32_t reported_deferred_ticks; // 前回ログ出力時点の値
+    bool input_deferred;              // 読み残しがある（エッジトリガーでは再通知されないので時間で起こす）
+
+    // 最後に処理した入力の通し番号（StateStamp.input_ack で返す）
+    uint32_t last_input_sequence;
+
+    // RTT・ジッター・損失の推定値
+    LinkQuality link_quality;
+
+    // 混雑に応じたスナップショットの間引き
+    SnapshotPacer snapshot_pacer;
+    uint8_t send_tail[sizeof(Packet)];  // 非ブロッキング送信で送り残したパケットの残り
+    int send_tail_length;               // 0: 残りなし（次の送信の前に必ず送り切る）
 };
 
 
 // サーバー初期化関連
 TCPsocket network_init_server(int port);
 TCPsocket network_accept_client(TCPsocket server_socket, Player players[], ClientConnection connections[]);
+// 先頭slot_count個のスロットのうち空いている最初のスロットへ割り当てる（満員なら-1）
+int network_assign_client(TCPsocket client, Player players[], ClientConnection connections[], int slot_count);
 void wait_for_clients(TCPsocket server_socket, Player players[], ClientConnection connections[]);
 void network_shutdown_server(TCPsocket server_socket);
 
+// 非ブロッキング送信の結果
+enum NetworkTrySendResult
+{
+    NETWORK_SEND_OK,        // 全部送った
+    NETWORK_SEND_PARTIAL,   // 一部だけ送り、残りを send_tail に持った
+    NETWORK_SEND_SKIPPED,   // 送信バッファが満杯（または送り残しがある）ので送らなかった
+    NETWORK_SEND_ERROR,
+};
+
 // 通信（送受信)
 int network_send_packet(TCPsocket client_socket, const Packet *packet);
+// 送り残しを先に送り切ってから送る（ブロッキング、必ず届けたいパケット用）
+int network_send_packet_to(ClientConnection *connection, const Packet *packet);
+// 待たずに送れるだけ送る（捨ててよいスナップショット用）
+NetworkTrySendResult network_try_send_packet(ClientConnection *connection, const Packet *packet);
+// 送り残しを捨てる（ソケットを閉じる・差し替えるとき）
+void network_clear_send_tail(ClientConnection *connection);
 int network_receive(TCPsocket client_socket, void *buffer, int size);
 int network_receive_packet(TCPsocket client_socket, Packet *packet);
 
+// 非ブロッキング受信の結果
+enum NetworkTryReceiveResult
+{
+    NETWORK_RECEIVE_OK,       // 1パケット受け取った
+    NETWORK_RECEIVE_PENDING,  // まだ1パケット分届いていない（何も読んでいない）
+    NETWORK_RECEIVE_ERROR,    // 切断・エラー・不正なパケット
+};
+
+// 1パケット分そろっていれば受け取り、そろっていなければ待たずに戻る（受け付け直後の接続用）
+NetworkTryReceiveResult network_try_receive_packet(TCPsocket client_socket, Packet *packet);
+// 受信したパケットのヘッダー（type・size）が処理してよい範囲か
+bool network_validate_packet(const Packet *packet);
+// 受信したままのtypeを整数として取り出す（範囲外の値を列挙型として読まないように）
+long long network_packet_raw_type(const Packet *packet);
+
 // クライアント管理
 void network_close_client(Player *player, ClientConnection *connection);
 
@@ -47,8 +190,50 @@ Packet create_packet_score(const GameScore *score);
 Packet create_packet_phase(GamePhase phase);
 Packet create_packet_ability_state(const AbilityState *state);
 Packet create_packet_match_result(int winner_id);
+Packet create_packet_session_token(int player_id, uint64_t token);
+Packet create_packet_extra_balls(const Ball balls[], const int owner_ids[], int count);
+Packet create_packet_score_detail(const ScoreDetailState *detail);
+Packet create_packet_ping(const PingPayload *ping);
+
+// 状態パケットの末尾にスタンプを書く
+void network_stamp_state(Packet *packet, const StateStamp *stamp);
+
+// 入力パケットの末尾から通し番号を読む（0: 番号なし）
+uint32_t network_input_sequence(const Packet *packet);
 
 // ユーティリティ関数
 int count_connected_clients(const Player players[]);
 
+// TCPsocketが内部に持つOSのソケットディスクリプタを取得（失敗時-1）
+int network_get_socket_fd(TCPsocket socket);
+
+// 受信バッファに溜まっているバイト数（失敗時0）
+int network_pending_bytes(TCPsocket socket);
+
+// 送信キューに残っている（相手に確認されていない）バイト数（失敗時-1）
+int network_send_queue_bytes(TCPsocket socket);
+
+// 環境変数で渡されたリスナーのディスクリプタをTCPsocketとして取り込む（なければNULL）
+TCPsocket network_adopt_listen_socket(const char *env_name);
+
+// SO_REUSEPORT付きで待ち受けるリスナーを開く（ワーカーモードの受付プロセスが使う。入れ替え用の新サーバーも同じポートで起動できる）
+TCPsocket network_open_reuseport_listener(int port);
+
+// 接続済みのクライアントのディスクリプタを別プロセスへ渡す経路（SOCK_SEQPACKETのUnixソケットのペア）
+// 1メッセージ = ディスクリプタ1つ（SCM_RIGHTS）+ 固定長のデータ
+// ホットリスタート後の再接続の転送と、ワーカーモードの受付プロセスからワーカーへの振り分けに使う
+bool network_open_fd_channel(TCPsocket *local, TCPsocket *remote);
+
+// fork・execで引き継いだ経路の端を取り込む（無効ならNULL）
+TCPsocket network_wrap_fd_channel(int fd);
+TCPsocket network_adopt_fd_channel(const char *env_name);
+
+// ディスクリプタを送る（送った後もこちらのディスクリプタは開いたまま）
+// 戻り値: 相手が終了しているなど送れなかった場合false
+bool network_send_fd(TCPsocket channel, int fd, const void *data, size_t size);
+
+// 1件受け取り、SDLNet_TCP_Accept が返すものと同じ形の TCPsocket にする
+// 戻り値: 1: clientとdataに入れた、0: もうない、-1: 相手が閉じた
+int network_receive_fd(TCPsocket channel, TCPsocket *client, void *data, size_t size);
+
 #endif
@@ -0,0 +1,37 @@
+#include "rate_limiter.h"
+
+void rate_limiter_init(RateLimiter *limiter, float rate_per_sec, float burst, Uint32 now_ms)
+{
+    limiter->tokens = burst;
+    limiter->rate_per_sec = rate_per_sec;
+    limiter->burst = burst;
+    limiter->last_refill_ms = now_ms;
+}
+
+bool rate_limiter_try_consume(RateLimiter *limiter, Uint32 now_ms)
+{
+    Uint32 elapsed_ms = now_ms - limiter->last_refill_ms;
+    if (elapsed_ms > 0)
+    {
+        limiter->tokens += limiter->rate_per_sec * (float)elapsed_ms / 1000.0f;
+        if (limiter->tokens > limiter->burst)
+            limiter->tokens = limiter->burst;
+        limiter->last_refill_ms = now_ms;
+    }
+
+    if (limiter->tokens < 1.0f)
+        return false;
+
+    limiter->tokens -= 1.0f;
+    return true;
+}
+
+Uint32 rate_limiter_ms_until_token(const RateLimiter *limiter, Uint32 now_ms)
+{
+    float tokens = limiter->tokens + limiter->rate_per_sec * (float)(now_ms - limiter->last_refill_ms) / 1000.0f;
+    if (tokens >= 1.0f)
+        return 0;
+
+    // 切り上げて、起きたときには確実に1つ溜まっているようにする
+    return (Uint32)((1.0f - tokens) * 1000.0f / limiter->rate_per_sec) + 1;
+}
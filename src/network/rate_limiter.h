@@ -0,0 +1,24 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <SDL2/SDL.h>
+
+// トークンバケット方式のレート制限
+struct RateLimiter
+{
+    float tokens;
+    float rate_per_sec;  // 1秒あたりの補充量
+    float burst;         // バケットの容量
+    Uint32 last_refill_ms;
+};
+
+// 満タンの状態で初期化
+void rate_limiter_init(RateLimiter *limiter, float rate_per_sec, float burst, Uint32 now_ms);
+
+// トークンを1つ消費する（足りなければfalse）
+bool rate_limiter_try_consume(RateLimiter *limiter, Uint32 now_ms);
+
+// 次のトークンが補充されるまでのミリ秒（今あれば0）
+Uint32 rate_limiter_ms_until_token(const RateLimiter *limiter, Uint32 now_ms);
+
+#endif
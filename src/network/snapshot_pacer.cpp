@@ -0,0 +1,69 @@
+#include "snapshot_pacer.h"
+#include "common/packet.h"
+#include "../server_constants.h"
+
+void snapshot_pacer_init(SnapshotPacer *pacer)
+{
+    pacer->interval = 1;
+    pacer->countdown = 0;
+    pacer->clear_rounds = 0;
+    pacer->due = false;
+    pacer->skipped = 0;
+    pacer->partial_sends = 0;
+}
+
+static void widen_interval(SnapshotPacer *pacer)
+{
+    pacer->interval *= 2;
+    if (pacer->interval > SNAPSHOT_MAX_INTERVAL_MULTIPLIER)
+        pacer->interval = SNAPSHOT_MAX_INTERVAL_MULTIPLIER;
+    pacer->countdown = pacer->interval;
+    pacer->clear_rounds = 0;
+}
+
+bool snapshot_pacer_begin_round(SnapshotPacer *pacer, int queued_bytes, bool backlog)
+{
+    const int congested_bytes = SNAPSHOT_CONGESTED_QUEUED_PACKETS * (int)sizeof(Packet);
+    const int clear_bytes = SNAPSHOT_CLEAR_QUEUED_PACKETS * (int)sizeof(Packet);
+
+    // 古いスナップショットが送信キューに溜まっているなら、新しいものを積まずに捨てる
+    if (backlog || queued_bytes > congested_bytes)
+    {
+        widen_interval(pacer);
+        pacer->skipped++;
+        pacer->due = false;
+        return false;
+    }
+
+    // 空いている状態が続いたら少しずつ元の間隔へ戻す
+    if (queued_bytes >= 0 && queued_bytes <= clear_bytes)
+    {
+        if (pacer->interval > 1 && ++pacer->clear_rounds >= SNAPSHOT_RECOVER_ROUNDS)
+        {
+            pacer->interval--;
+            pacer->clear_rounds = 0;
+            if (pacer->countdown > pacer->interval)
+                pacer->countdown = pacer->interval;
+        }
+    }
+    else
+    {
+        pacer->clear_rounds = 0;
+    }
+
+    if (--pacer->countdown > 0)
+    {
+        pacer->due = false;
+        return false;
+    }
+    pacer->countdown = pacer->interval;
+    pacer->due = true;
+    return true;
+}
+
+void snapshot_pacer_on_partial_send(SnapshotPacer *pacer)
+{
+    pacer->partial_sends++;
+    pacer->due = false;
+    widen_interval(pacer);
+}
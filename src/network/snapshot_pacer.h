@@ -0,0 +1,31 @@
+#ifndef SNAPSHOT_PACER_H
+#define SNAPSHOT_PACER_H
+
+#include <stdint.h>
+
+// クライアントごとのスナップショット送信間隔の調整
+// 送信キューが詰まったら間隔を倍にし、空いている状態が続いたら1ずつ戻す
+struct SnapshotPacer
+{
+    int interval;        // 何回のスナップショット機会に1回送るか（1: 毎回）
+    int countdown;       // 次に送るまでの機会数
+    int clear_rounds;    // 送信キューが空いていた連続回数
+    bool due;            // 今回の機会に送るか
+
+    uint32_t skipped;        // 混雑で捨てたスナップショット（累計）
+    uint32_t partial_sends;  // 送り切れなかった送信（累計）
+};
+
+// 毎回送る状態で初期化
+void snapshot_pacer_init(SnapshotPacer *pacer);
+
+// スナップショット機会の最初に呼び、今回送るかを決める
+// queued_bytes: ソケットの送信キューに残っているバイト数（-1: 取得できない）
+// backlog: 前回送り切れなかった残りがある
+bool snapshot_pacer_begin_round(SnapshotPacer *pacer, int queued_bytes, bool backlog);
+
+// 送信が途中で止まった（カーネルの送信バッファが満杯）
+// 残りのスナップショットは捨て、間隔を広げる
+void snapshot_pacer_on_partial_send(SnapshotPacer *pacer);
+
+#endif
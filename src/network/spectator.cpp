@@ -0,0 +1,171 @@
+#include "spectator.h"
+#include "../log.h"
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+bool spectator_init(SpectatorHub *hub, int port)
+{
+    memset(hub, 0, sizeof(SpectatorHub));
+
+    if (port <= 0)
+    {
+        LOG_INFO("観戦者リスナー無効");
+        return true;
+    }
+
+    hub->listen_socket = network_adopt_listen_socket(SPECTATOR_LISTEN_FD_ENV);
+    if (hub->listen_socket)
+    {
+        LOG_SUCCESS("観戦者リスナー起動: 引き継いだリスナーを使用 (ポート " << port << ")");
+        return true;
+    }
+
+    IPaddress ip;
+    if (SDLNet_ResolveHost(&ip, nullptr, port) < 0)
+    {
+        LOG_ERROR("観戦者ホスト解決失敗: " << SDLNet_GetError());
+        return false;
+    }
+
+    hub->listen_socket = SDLNet_TCP_Open(&ip);
+    if (!hub->listen_socket)
+    {
+        LOG_ERROR("観戦者ソケット作成失敗: " << SDLNet_GetError());
+        return false;
+    }
+
+    LOG_SUCCESS("観戦者リスナー起動: ポート " << port);
+    return true;
+}
+
+TCPsocket spectator_accept(SpectatorHub *hub)
+{
+    if (!hub->listen_socket)
+        return nullptr;
+
+    TCPsocket client = SDLNet_TCP_Accept(hub->listen_socket);
+    if (!client)
+        return nullptr;
+    return spectator_add(hub, client);
+}
+
+TCPsocket spectator_add(SpectatorHub *hub, TCPsocket client)
+{
+    if (hub->count >= MAX_SPECTATORS)
+    {
+        LOG_WARN("観戦者満員");
+        SDLNet_TCP_Close(client);
+        return nullptr;
+    }
+
+    SpectatorConnection *spectator = &hub->spectators[hub->count++];
+    spectator->socket = client;
+    spectator->fd = network_get_socket_fd(client);
+    LOG_INFO("観戦者接続 (合計 " << hub->count << ")");
+    return client;
+}
+
+// パケットの内容から保持先スロットを決める（該当なしは-1）
+static int spectator_slot_for(const Packet *packet)
+{
+    if (packet->type == PACKET_TYPE_EXTRA_BALLS)
+        return SPECTATOR_SLOT_EXTRA_BALLS;
+    if (packet->type == PACKET_TYPE_SCORE_DETAIL)
+        return SPECTATOR_SLOT_SCORE_DETAIL;
+
+    switch ((PacketType)packet->type)
+    {
+        case PACKET_TYPE_GAME_PHASE:
+            return SPECTATOR_SLOT_PHASE;
+        case PACKET_TYPE_SCORE_UPDATE:
+            return SPECTATOR_SLOT_SCORE;
+        case PACKET_TYPE_BALL_STATE:
+            return SPECTATOR_SLOT_BALL;
+        case PACKET_TYPE_MATCH_RESULT:
+            return SPECTATOR_SLOT_MATCH_RESULT;
+        case PACKET_TYPE_PLAYER_STATE:
+        {
+            Player player;
+            memcpy(&player, packet->data, sizeof(Player));
+            if (player.player_id < 0 || player.player_id >= MAX_CLIENTS)
+                return -1;
+            return SPECTATOR_SLOT_PLAYER + player.player_id;
+        }
+        case PACKET_TYPE_ABILITY_STATE:
+        {
+            AbilityState state;
+            memcpy(&state, packet->data, sizeof(AbilityState));
+            if (state.player_id < 0 || state.player_id >= MAX_CLIENTS)
+                return -1;
+            return SPECTATOR_SLOT_ABILITY + state.player_id;
+        }
+        default:
+            return -1;
+    }
+}
+
+void spectator_publish(SpectatorHub *hub, const Packet *packet)
+{
+    if (hub->count == 0 || !packet)
+        return;
+
+    int slot = spectator_slot_for(packet);
+    if (slot < 0)
+        return;
+
+    hub->latest[slot] = *packet;
+    hub->dirty[slot] = true;
+}
+
+static void spectator_remove(SpectatorHub *hub, int index)
+{
+    SDLNet_TCP_Close(hub->spectators[index].socket);
+    hub->spectators[index] = hub->spectators[--hub->count];
+    LOG_INFO("観戦者切断 (合計 " << hub->count << ")");
+}
+
+void spectator_flush(SpectatorHub *hub, int interval_ticks)
+{
+    if (hub->count == 0)
+        return;
+
+    if (++hub->ticks_since_flush < interval_ticks)
+        return;
+    hub->ticks_since_flush = 0;
+
+    // 変更のあったスロットだけを1つのフレームに詰める
+    int frame_count = 0;
+    for (int slot = 0; slot < SPECTATOR_SLOT_COUNT; slot++)
+    {
+        if (!hub->dirty[slot])
+            continue;
+        hub->frame[frame_count++] = hub->latest[slot];
+        hub->dirty[slot] = false;
+    }
+
+    if (frame_count == 0)
+        return;
+
+    // 非ブロッキング送信: 送り切れない観戦者はティックを止めずに切断する
+    const size_t frame_size = frame_count * sizeof(Packet);
+    for (int i = hub->count - 1; i >= 0; i--)
+    {
+        ssize_t sent = send(hub->spectators[i].fd, hub->frame, frame_size, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent != (ssize_t)frame_size)
+            spectator_remove(hub, i);
+    }
+}
+
+void spectator_shutdown(SpectatorHub *hub)
+{
+    while (hub->count > 0)
+        spectator_remove(hub, hub->count - 1);
+
+    if (hub->listen_socket)
+    {
+        SDLNet_TCP_Close(hub->listen_socket);
+        hub->listen_socket = nullptr;
+    }
+}
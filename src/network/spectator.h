@@ -0,0 +1,69 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include <SDL2/SDL_net.h>
+#include "network.h"
+
+#define MAX_SPECTATORS 512
+
+// 観戦者に送るパケットの種類（最新値のみ保持するスロット）
+enum SpectatorSlot {
+    SPECTATOR_SLOT_PHASE = 0,
+    SPECTATOR_SLOT_SCORE,
+    SPECTATOR_SLOT_SCORE_DETAIL,
+    SPECTATOR_SLOT_ABILITY,                                   // + player_id
+    SPECTATOR_SLOT_PLAYER = SPECTATOR_SLOT_ABILITY + MAX_CLIENTS, // + player_id
+    SPECTATOR_SLOT_BALL = SPECTATOR_SLOT_PLAYER + MAX_CLIENTS,
+    SPECTATOR_SLOT_EXTRA_BALLS,
+    SPECTATOR_SLOT_MATCH_RESULT,
+    SPECTATOR_SLOT_COUNT
+};
+
+// 観戦者1人分の接続
+struct SpectatorConnection
+{
+    TCPsocket socket;
+    int fd;
+};
+
+// 観戦者の管理構造体
+// プレイヤーとは別のリスナーで受け付け、プレイヤースロットを消費しない
+struct SpectatorHub
+{
+    TCPsocket listen_socket;
+
+    SpectatorConnection spectators[MAX_SPECTATORS];
+    int count;
+
+    // スロットごとの最新パケット（送信間隔内の中間状態は上書きされる）
+    Packet latest[SPECTATOR_SLOT_COUNT];
+    bool dirty[SPECTATOR_SLOT_COUNT];
+
+    // 1回だけエンコードして全観戦者へ送るフレーム
+    Packet frame[SPECTATOR_SLOT_COUNT];
+
+    int ticks_since_flush;
+};
+
+// 観戦者用リスナーを開く（port <= 0 なら無効）
+bool spectator_init(SpectatorHub *hub, int port);
+
+// 観戦者の新規接続を受け付ける
+// 戻り値: 追加した観戦者のソケット（なければNULL）
+TCPsocket spectator_accept(SpectatorHub *hub);
+
+// 受け付け済みの接続を観戦者に加える（満員なら閉じる）
+// 戻り値: 追加した観戦者のソケット（満員ならNULL）
+TCPsocket spectator_add(SpectatorHub *hub, TCPsocket client);
+
+// ブロードキャストしたパケットを観戦者向けに記録する
+void spectator_publish(SpectatorHub *hub, const Packet *packet);
+
+// 送信間隔に達していれば、溜まった最新状態をまとめて全観戦者へ送る
+// interval_ticks: 何tickごとに送るか
+void spectator_flush(SpectatorHub *hub, int interval_ticks);
+
+// 全観戦者を切断し、リスナーを閉じる
+void spectator_shutdown(SpectatorHub *hub);
+
+#endif
@@ -1,5 +1,6 @@
 #include "ball_physics.h"
 #include "common/game_constants.h"
+#include "game/team.h"
 #include <math.h>
 
 // ベクトル計算
@@ -24,36 +25,6 @@ Point3d point3d_normalize(Point3d v)
     return r;
 }
 
-// ボールの更新
-void update_ball(Ball *ball, float dt)
-{
-    // 前フレームのZ座標を保存（ネット判定用）
-    ball->previous_z = ball->point.z;
-
-    // 重力倍率（未設定なら1.0）
-    float gravity_mult = (ball->gravity_multiplier > 0.0f) ? ball->gravity_multiplier : 1.0f;
-
-    // 重力 (Y軸マイナス方向へ)
-    ball->velocity.y -= GameConstants::GRAVITY * gravity_mult * dt;
-
-    // 位置の更新
-    ball->point = point3d_add(ball->point, point3d_mul(ball->velocity, dt));
-}
-
-// バウンド処理
-bool handle_bounce(Ball *ball, float ground_y, float restitution)
-{
-    bool bounced = false;
-    // ボールが地面以下にあり、かつ下向きに移動している場合のみバウンド
-    if (ball->point.y <= ground_y && ball->velocity.y < 0)
-    {
-        ball->point.y = ground_y;
-        ball->velocity.y = -ball->velocity.y * restitution;
-        bounced = true;
-    }
-    return bounced;
-}
-
 // ラケットでの打撃処理
 void handle_racket_hit(Ball *ball, Point3d direction, float power)
 {
@@ -65,12 +36,12 @@ void handle_racket_hit(Ball *ball, Point3d direction, float power)
 void reset_ball(Ball *ball, int server_player_id)
 {
     // サーバーのプレイヤーIDに応じて初期位置を設定
-    // Player0 (ID=0): 手前側 (Z > 0)
-    // Player1 (ID=1): 奥側 (Z < 0)
+    // 偶数ID（チーム0）: 手前側 (Z > 0)
+    // 奇数ID（チーム1）: 奥側 (Z < 0)
 
     constexpr float SERVE_POSITION_Z = GameConstants::PLAYER_BASELINE_DISTANCE - GameConstants::BALL_SERVE_OFFSET_FROM_BASELINE;
 
-    if (server_player_id == 0)
+    if (team_of(server_player_id) == 0)
         ball->point = (Point3d){0.0f, GameConstants::BALL_SERVE_HEIGHT, SERVE_POSITION_Z};
     else
         ball->point = (Point3d){0.0f, GameConstants::BALL_SERVE_HEIGHT, -SERVE_POSITION_Z};
@@ -8,11 +8,20 @@ Point3d point3d_add(Point3d a, Point3d b);
 Point3d point3d_mul(Point3d v, float k);
 Point3d point3d_normalize(Point3d v);
 
-// ボールの更新
-void update_ball(Ball *ball, float dt);
+// ボールを1tick進める（重力と移動。バウンドはコート面ごとの処理で行う）
+// gravity_step: GRAVITY * dt（呼び出し側がループの外で1回だけ計算する）
+// gravity_multiplier は常に正（初期化・リセット・打球のたびに設定される）なので、そのまま掛ける
+inline void integrate_ball(Ball *ball, float dt, float gravity_step)
+{
+    // 前フレームのZ座標を保存（ネット判定用）
+    ball->previous_z = ball->point.z;
 
-// バウンド処理
-bool handle_bounce(Ball *ball, float ground_y, float restitution);
+    ball->velocity.y -= gravity_step * ball->gravity_multiplier;
+
+    ball->point.x += ball->velocity.x * dt;
+    ball->point.y += ball->velocity.y * dt;
+    ball->point.z += ball->velocity.z * dt;
+}
 
 // ラケットでの打撃処理
 void handle_racket_hit(Ball *ball, Point3d direction, float power);
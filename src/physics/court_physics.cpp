@@ -0,0 +1,87 @@
+#include "court_physics.h"
+#include <string.h>
+#include "common/game_constants.h"
+#include "physics/ball_physics.h"
+#include "../server_constants.h"
+
+// コート面の定数（テンプレート引数として渡す）
+struct HardCourt
+{
+    static constexpr float RESTITUTION = GameConstants::BOUNCE_RESTITUTION;
+    static constexpr float FRICTION = 1.0f;
+};
+
+struct ClayCourt
+{
+    static constexpr float RESTITUTION = GameConstants::BOUNCE_RESTITUTION * CLAY_RESTITUTION_SCALE;
+    static constexpr float FRICTION = CLAY_BOUNCE_FRICTION;
+};
+
+struct GrassCourt
+{
+    static constexpr float RESTITUTION = GameConstants::BOUNCE_RESTITUTION * GRASS_RESTITUTION_SCALE;
+    static constexpr float FRICTION = GRASS_BOUNCE_FRICTION;
+};
+
+template <typename Surface>
+static inline bool bounce_on(Ball *ball)
+{
+    static_assert(Surface::RESTITUTION > 0.0f && Surface::RESTITUTION < 1.0f, "restitution must be in (0, 1)");
+    static_assert(Surface::FRICTION > 0.0f && Surface::FRICTION <= 1.0f, "friction must be in (0, 1]");
+
+    if (!(ball->point.y <= GameConstants::GROUND_Y && ball->velocity.y < 0.0f))
+        return false;
+
+    ball->point.y = GameConstants::GROUND_Y;
+    ball->velocity.y = -ball->velocity.y * Surface::RESTITUTION;
+
+    // 水平方向の減速がない面（ハード）は掛け算ごと消える
+    if constexpr (Surface::FRICTION != 1.0f)
+    {
+        ball->velocity.x *= Surface::FRICTION;
+        ball->velocity.z *= Surface::FRICTION;
+    }
+    return true;
+}
+
+template <typename Surface>
+static uint32_t step_balls_on(Ball balls[], int count, float dt)
+{
+    const float gravity_step = GameConstants::GRAVITY * dt;
+
+    uint32_t bounced = 0;
+    for (int i = 0; i < count; i++)
+    {
+        integrate_ball(&balls[i], dt, gravity_step);
+        if (bounce_on<Surface>(&balls[i]))
+            bounced |= 1u << i;
+    }
+    return bounced;
+}
+
+// 添字は CourtSurface
+static const CourtPhysics COURT_PHYSICS[COURT_SURFACE_COUNT] = {
+    {"hard", step_balls_on<HardCourt>},
+    {"clay", step_balls_on<ClayCourt>},
+    {"grass", step_balls_on<GrassCourt>},
+};
+
+const CourtPhysics *court_physics(CourtSurface surface)
+{
+    if ((int)surface < 0 || surface >= COURT_SURFACE_COUNT)
+        surface = COURT_SURFACE_HARD;
+    return &COURT_PHYSICS[surface];
+}
+
+bool court_surface_from_name(const char *name, CourtSurface *surface)
+{
+    for (int i = 0; i < COURT_SURFACE_COUNT; i++)
+    {
+        if (strcmp(name, COURT_PHYSICS[i].name) == 0)
+        {
+            *surface = (CourtSurface)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,35 @@
+#ifndef COURT_PHYSICS_H
+#define COURT_PHYSICS_H
+
+#include <stdint.h>
+#include "common/ball.h"
+
+// コート面（試合ごとに選ぶ）
+typedef enum
+{
+    COURT_SURFACE_HARD,
+    COURT_SURFACE_CLAY,
+    COURT_SURFACE_GRASS,
+    COURT_SURFACE_COUNT,
+} CourtSurface;
+
+// コート面ごとの物理処理
+// 各面の定数はコンパイル時に畳み込まれ、試合開始時に表から関数を選んでおけば試合中に面による分岐はない
+struct CourtPhysics
+{
+    const char *name;
+
+    // 全ボールを1tick進める（重力・移動の後、地面以下で下向きのボールを跳ね返す）
+    // 面ごとに積分とバウンドを1つのループとしてインスタンス化してある
+    // 戻り値: バウンドしたボールのビットマスク（bit i: balls[i]）
+    uint32_t (*step_balls)(Ball balls[], int count, float dt);
+};
+
+// コート面の物理処理（範囲外はハードコート）
+const CourtPhysics *court_physics(CourtSurface surface);
+
+// 名前（hard / clay / grass）からコート面を選ぶ
+// 戻り値: 既知の名前ならtrue
+bool court_surface_from_name(const char *name, CourtSurface *surface);
+
+#endif
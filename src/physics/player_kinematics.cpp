@@ -0,0 +1,85 @@
+#include "player_kinematics.h"
+#include <math.h>
+#include <string.h>
+#include "common/game_constants.h"
+#include "../server_constants.h"
+
+void player_kinematics_init(PlayerKinematics *kinematics)
+{
+    memset(kinematics, 0, sizeof(PlayerKinematics));
+}
+
+void player_kinematics_set_intent(PlayerKinematics *kinematics, int player_id, float dir_x, float dir_z)
+{
+    float len = sqrtf(dir_x * dir_x + dir_z * dir_z);
+    if (len > GameConstants::PLAYER_MOVEMENT_EPSILON)
+    {
+        dir_x /= len;
+        dir_z /= len;
+    }
+    else
+    {
+        dir_x = 0.0f;
+        dir_z = 0.0f;
+    }
+
+    kinematics->intent_x[player_id] = dir_x;
+    kinematics->intent_z[player_id] = dir_z;
+    kinematics->intent_hold[player_id] = PLAYER_INPUT_HOLD_SEC;
+}
+
+bool player_kinematics_at_rest(const PlayerKinematics *kinematics, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (kinematics->vx[i] != 0.0f || kinematics->vz[i] != 0.0f || kinematics->intent_hold[i] > 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// fminf/fmaxf は非数の扱いのため既定の最適化ではベクトル化されないので、比較による選択で書く
+static inline float clampf(float value, float lo, float hi)
+{
+    value = (value < lo) ? lo : value;
+    return (value > hi) ? hi : value;
+}
+
+// ループ内に分岐を置かない（条件は選択で表す）ので、コンパイラがそのままベクトル化できる
+// 配列が重ならないことを restrict で伝えるため、引数で受け取る
+static void integrate_lanes(float *__restrict x, float *__restrict z, float *__restrict vx, float *__restrict vz,
+                            const float *__restrict intent_x, const float *__restrict intent_z,
+                            float *__restrict intent_hold, const float *__restrict max_speed,
+                            const float *__restrict min_x, const float *__restrict max_x,
+                            const float *__restrict min_z, const float *__restrict max_z, int count, float dt)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float active = (intent_hold[i] > 0.0f) ? 1.0f : 0.0f;
+        float hold = intent_hold[i] - dt;
+        intent_hold[i] = (hold > 0.0f) ? hold : 0.0f;
+
+        // 目標速度へ一定の加速度で近づける（入力が切れたら摩擦で0へ）
+        float target_vx = intent_x[i] * max_speed[i] * active;
+        float target_vz = intent_z[i] * max_speed[i] * active;
+        float step = (active * PLAYER_ACCELERATION + (1.0f - active) * PLAYER_DECELERATION) * dt;
+        float next_vx = vx[i] + clampf(target_vx - vx[i], -step, step);
+        float next_vz = vz[i] + clampf(target_vz - vz[i], -step, step);
+
+        // 範囲の端に当たったら、その軸の速度を失う
+        float next_x = x[i] + next_vx * dt;
+        float next_z = z[i] + next_vz * dt;
+        float clamped_x = clampf(next_x, min_x[i], max_x[i]);
+        float clamped_z = clampf(next_z, min_z[i], max_z[i]);
+        vx[i] = (clamped_x == next_x) ? next_vx : 0.0f;
+        vz[i] = (clamped_z == next_z) ? next_vz : 0.0f;
+        x[i] = clamped_x;
+        z[i] = clamped_z;
+    }
+}
+
+void kinematics_integrate(const KinematicsLanes *lanes, int count, float dt)
+{
+    integrate_lanes(lanes->x, lanes->z, lanes->vx, lanes->vz, lanes->intent_x, lanes->intent_z, lanes->intent_hold,
+                    lanes->max_speed, lanes->min_x, lanes->max_x, lanes->min_z, lanes->max_z, count, dt);
+}
@@ -0,0 +1,50 @@
+#ifndef PLAYER_KINEMATICS_H
+#define PLAYER_KINEMATICS_H
+
+#include "network/network.h"
+
+// プレイヤーの移動（加速・減速とコート範囲の制限）
+// 入力は向きを決めるだけで、位置は毎tick 1回の積分でまとめて進める
+// 成分ごとの配列で持つので、複数試合分を同じ並びに詰めても同じ関数で進められる
+
+// 1試合分の運動状態（先頭 player_count 要素を使う）
+struct PlayerKinematics
+{
+    float vx[MAX_CLIENTS];
+    float vz[MAX_CLIENTS];
+    float intent_x[MAX_CLIENTS];     // 入力の向き（正規化済み、入力なしは0）
+    float intent_z[MAX_CLIENTS];
+    float intent_hold[MAX_CLIENTS];  // 入力が有効な残り秒数（切れたら減速する）
+};
+
+// 積分する count 人分の配列（それぞれ count 要素、互いに重ならないこと）
+struct KinematicsLanes
+{
+    float *x;
+    float *z;
+    float *vx;
+    float *vz;
+    const float *intent_x;
+    const float *intent_z;
+    float *intent_hold;
+    const float *max_speed;
+    const float *min_x;
+    const float *max_x;
+    const float *min_z;
+    const float *max_z;
+};
+
+// 静止・入力なしで初期化
+void player_kinematics_init(PlayerKinematics *kinematics);
+
+// 入力の向きを設定する（dir_x, dir_z は正規化する、0なら止まる）
+void player_kinematics_set_intent(PlayerKinematics *kinematics, int player_id, float dir_x, float dir_z);
+
+// 全員が止まっていて入力もないか
+bool player_kinematics_at_rest(const PlayerKinematics *kinematics, int count);
+
+// count 人分を dt 秒進める
+// 速度は向き×最高速度へ加速（入力が切れたら0へ減速）し、範囲の端では外向きの速度を0にする
+void kinematics_integrate(const KinematicsLanes *lanes, int count, float dt);
+
+#endif
@@ -0,0 +1,169 @@
+#include "ai_player.h"
+#include <math.h>
+#include <string.h>
+#include "common/game_constants.h"
+#include "game/team.h"
+#include "../server_constants.h"
+
+static uint32_t ai_next_random(AiPlayer *ai)
+{
+    uint32_t x = ai->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    ai->rng = x;
+    return x;
+}
+
+// 0.0〜1.0の乱数
+static float ai_random01(AiPlayer *ai)
+{
+    return (float)(ai_next_random(ai) >> 8) / (float)(1u << 24);
+}
+
+void ai_player_init(AiPlayer *ai, float skill, uint32_t seed)
+{
+    ai->enabled = true;
+    ai->skill = skill;
+    ai->rng = seed ? seed : 1u;
+    ai->decided_hit_count = -1;
+    ai->will_swing = false;
+    ai->serve_wait_sec = AI_SERVE_WAIT_SEC;
+}
+
+Point3d ai_predict_landing(const Ball *ball)
+{
+    float gravity_mult = (ball->gravity_multiplier > 0.0f) ? ball->gravity_multiplier : 1.0f;
+    float g = GameConstants::GRAVITY * gravity_mult;
+    float height = ball->point.y - GameConstants::GROUND_Y;
+    if (height < 0.0f)
+        height = 0.0f;
+
+    // y(t) = height + vy*t - g*t^2/2 = 0 の正の解
+    float vy = ball->velocity.y;
+    float t = (vy + sqrtf(vy * vy + 2.0f * g * height)) / g;
+
+    Point3d landing = {
+        ball->point.x + ball->velocity.x * t,
+        GameConstants::GROUND_Y,
+        ball->point.z + ball->velocity.z * t
+    };
+    return landing;
+}
+
+// 自分のコート側（Z符号）: Player0 は手前 (Z > 0)
+static float court_side(const Player *player)
+{
+    return (player->point.z >= GameConstants::NET_POSITION_Z) ? 1.0f : -1.0f;
+}
+
+static void ai_steer(const Player *player, float target_x, float target_z, PlayerInput *input)
+{
+    float dx = target_x - player->point.x;
+    float dz = target_z - player->point.z;
+
+    if (dx > AI_MOVE_DEADZONE) input->right = true;
+    else if (dx < -AI_MOVE_DEADZONE) input->left = true;
+
+    if (dz < -AI_MOVE_DEADZONE) input->front = true;
+    else if (dz > AI_MOVE_DEADZONE) input->back = true;
+}
+
+// 相手チームの左右の重心（ダブルスは2人の平均）
+static float opponents_center_x(const GameState *state, int player_id)
+{
+    int team = opponent_team(team_of(player_id));
+    float sum = 0.0f;
+    int count = 0;
+    for (int i = team; i < state->player_count; i += TEAM_COUNT)
+    {
+        sum += state->players[i].point.x;
+        count++;
+    }
+    return (count > 0) ? sum / (float)count : 0.0f;
+}
+
+// 相手のいない側へ打ち返す
+static void ai_make_swing(AiPlayer *ai, float opponents_x, PlayerSwing *swing)
+{
+    float aim = (opponents_x > 0.0f) ? -1.0f : 1.0f;
+
+    swing->acc_x = aim * SWING_ACC_MAX_X * (0.3f + 0.7f * ai_random01(ai));
+    swing->acc_y = SWING_ACC_MAX_Y * (0.2f + 0.4f * ai_random01(ai));
+    swing->acc_z = SWING_ACC_MAX_Z * ai_random01(ai);
+    if (ai_random01(ai) < AI_LOB_CHANCE)
+        swing->shot_type = SHOT_TYPE_LOB;
+}
+
+bool ai_player_think(AiPlayer *ai, const GameState *state, int player_id, float dt, PlayerInput *input, PlayerSwing *swing)
+{
+    memset(input, 0, sizeof(PlayerInput));
+    memset(swing, 0, sizeof(PlayerSwing));
+
+    const Player *self = &state->players[player_id];
+    const float opponents_x = opponents_center_x(state, player_id);
+    const Ball *ball = &state->balls[PRIMARY_BALL];  // 分身には釣られない
+    const float side = court_side(self);
+    const float home_x = player_home_x(state, player_id);
+    const float home_z = side * GameConstants::PLAYER_BASELINE_DISTANCE * AI_HOME_DEPTH_RATIO;
+
+    float dx = self->point.x - ball->point.x;
+    float dy = self->point.y - ball->point.y;
+    float dz = self->point.z - ball->point.z;
+    bool in_reach = sqrtf(dx * dx + dy * dy + dz * dz) <= PLAYER_SWING_RADIUS * AI_SWING_REACH_RATIO;
+
+    if (state->phase == GAME_PHASE_START_GAME)
+    {
+        // サーブ権があれば少し待ってから打つ
+        bool serving = ball->last_hit_player_id == player_id;
+        if (serving && in_reach)
+        {
+            ai->serve_wait_sec -= dt;
+            if (ai->serve_wait_sec > 0.0f)
+                return false;
+            ai->serve_wait_sec = AI_SERVE_WAIT_SEC;
+            ai_make_swing(ai, opponents_x, swing);
+            return true;
+        }
+        // サーバーはボールの左右位置まで寄る（ダブルスの持ち場はコート中央から外れている）
+        ai_steer(self, serving ? ball->point.x : home_x, home_z, input);
+        return false;
+    }
+
+    if (state->phase != GAME_PHASE_IN_RALLY)
+        return false;
+
+    // 相手チームの打球が自分の側へ向かっているときだけ追う
+    bool incoming = team_of(ball->last_hit_player_id) != team_of(player_id) && ball->velocity.z * side > 0.0f;
+    if (!incoming)
+    {
+        ai_steer(self, home_x, home_z, input);
+        return false;
+    }
+
+    // 打球ごとに1回だけ、打ち返すかどうかを決める
+    if (ai->decided_hit_count != ball->hit_count)
+    {
+        ai->decided_hit_count = ball->hit_count;
+        ai->will_swing = ai_random01(ai) >= (1.0f - ai->skill) * AI_MAX_MISS_CHANCE;
+    }
+
+    // バウンド前は着地予測点、バウンド後はボールそのものへ向かう
+    Point3d target = (ball->bounce_count == 0) ? ai_predict_landing(ball) : ball->point;
+    if (target.z * side < 0.0f)
+        target.z = GameConstants::NET_POSITION_Z;
+
+    // ダブルスでは自分のレーン（左右）に来る打球だけを追い、もう片方は持ち場に残る
+    bool my_lane = state->player_count <= TEAM_COUNT || ((target.x < 0.0f) == (home_x < 0.0f));
+    if (my_lane)
+        ai_steer(self, target.x, target.z, input);
+    else
+        ai_steer(self, home_x, home_z, input);
+
+    if (in_reach && ai->will_swing)
+    {
+        ai_make_swing(ai, opponents_x, swing);
+        return true;
+    }
+    return false;
+}
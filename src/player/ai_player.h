@@ -0,0 +1,30 @@
+#ifndef AI_PLAYER_H
+#define AI_PLAYER_H
+
+#include <stdint.h>
+#include "common/player_input.h"
+#include "common/player_swing.h"
+#include "game/game_state.h"
+
+// サーバー側で操作するプレイヤーの状態
+struct AiPlayer
+{
+    bool enabled;
+    float skill;           // 0.0〜1.0（低いほど打ち損じが増える）
+    uint32_t rng;          // 乱数状態（xorshift32）
+    int decided_hit_count; // 打つかどうかを決めた打球（ball.hit_count）
+    bool will_swing;       // その打球を打ち返すか
+    float serve_wait_sec;  // サーブまでの残り時間（シミュレーションレートに依らないよう秒で数える）
+};
+
+// 初期化（seedは0以外）
+void ai_player_init(AiPlayer *ai, float skill, uint32_t seed);
+
+// ボールの着地予測点（地面に達する位置、上昇中でも次の着地点を返す）
+Point3d ai_predict_landing(const Ball *ball);
+
+// GameStateを直接読み、1tick分（dt秒）の操作を決める
+// 戻り値: スイングする場合true（swingに内容が入る）
+bool ai_player_think(AiPlayer *ai, const GameState *state, int player_id, float dt, PlayerInput *input, PlayerSwing *swing);
+
+#endif
@@ -8,8 +8,77 @@ constexpr float TIME_GAME_FINISHED = 1.0f;
 // ネットワークタイムアウト
 constexpr int NETWORK_RECEIVE_MAX_ATTEMPTS = 100;
 constexpr int SOCKET_TIMEOUT_CLIENT_WAIT_MS = 100;
-constexpr int SOCKET_TIMEOUT_INIT_WAIT_MS = 500;
-constexpr int SOCKET_TIMEOUT_MAIN_LOOP_MS = 10;
+
+// 受信レート制限（クライアントごと）
+constexpr int MAX_PACKETS_PER_CLIENT_PER_TICK = 8;   // 1tickで処理するパケット数の上限
+constexpr float CLIENT_PACKET_RATE_PER_SEC = 120.0f; // トークン補充量
+constexpr float CLIENT_PACKET_BURST = 30.0f;         // バースト許容量
+
+// 接続受付のレート制限（リスナーごと）
+constexpr float ACCEPT_RATE_PER_SEC = 20.0f;
+constexpr float ACCEPT_BURST = 10.0f;
+
+// 受信制限中クライアントのログ出力間隔
+constexpr int THROTTLE_REPORT_INTERVAL_MS = 1000;
+
+// 接続品質の計測（クライアントごと）
+constexpr int PING_INTERVAL_MS = 1000;               // pingの送信間隔（これを過ぎても応答がなければ損失）
+constexpr float LINK_RTT_EWMA_ALPHA = 0.125f;
+constexpr float LINK_JITTER_EWMA_ALPHA = 0.25f;
+constexpr float LINK_LOSS_EWMA_ALPHA = 0.1f;
+constexpr int LINK_QUALITY_REPORT_INTERVAL_MS = 10000;
+
+// 混雑したクライアントへのスナップショット間引き
+constexpr int SNAPSHOT_CONGESTED_QUEUED_PACKETS = 16;  // 送信キューがこれを超えたら混雑
+constexpr int SNAPSHOT_CLEAR_QUEUED_PACKETS = 2;       // これ以下なら空いている
+constexpr int SNAPSHOT_RECOVER_ROUNDS = 8;             // 空いている回数がこれだけ続いたら間隔を1戻す
+constexpr int SNAPSHOT_MAX_INTERVAL_MULTIPLIER = 8;    // 間引きの上限（スナップショット機会の何回に1回か）
+
+// 入力の妥当性検査（クライアントごと）
+constexpr int ANTI_CHEAT_MIN_SWING_INTERVAL_MS = 150;  // これより短い間隔のスイングは捨てる
+constexpr float ANTI_CHEAT_ACC_LIMIT = 160.0f;         // 加速度の大きさの上限（約16G、センサーの測定範囲）
+constexpr int ANTI_CHEAT_ACC_WARMUP_SWINGS = 8;        // 統計による判定を始めるまでのスイング数
+constexpr float ANTI_CHEAT_ACC_EWMA_ALPHA = 0.125f;
+constexpr float ANTI_CHEAT_ACC_OUTLIER_SIGMA = 4.0f;   // 平均からこの標準偏差倍を超えたら外れ値
+constexpr float ANTI_CHEAT_ACC_OUTLIER_MARGIN = 1.0f;  // ばらつきが小さいときの許容幅
+constexpr float ANTI_CHEAT_ACC_MIN_STDDEV = 0.01f;     // これ未満は毎回同じ値（自動入力）とみなす
+
+// 再接続
+constexpr int RECONNECT_GRACE_MS = 15000;     // 切断後にスロットを保持する時間
+constexpr int MAX_PENDING_RESUMES = 4;        // 再接続要求待ちソケットの上限
+
+// マッチング
+constexpr int MATCHMAKING_DEFAULT_RATING = 1500;       // 期限までにレーティングを通知しなかった接続
+constexpr int MATCHMAKING_JOIN_TIMEOUT_MS = 3000;      // 接続からMATCHMAKING_JOINを待つ時間（過ぎたらデフォルト値で組む）
+constexpr int MATCHMAKING_BUCKET_WIDTH = 50;           // 1バケットあたりのレーティング幅
+constexpr int MATCHMAKING_INITIAL_WINDOW_BUCKETS = 1;  // 待ち始めに許容するバケット差
+constexpr int MATCHMAKING_WIDEN_INTERVAL_MS = 2000;    // この時間ごとに許容範囲を1バケット広げる
+constexpr int MATCHMAKING_MAX_WAIT_MS = 30000;         // これを超えたらレーティングを問わない
+constexpr int MATCHMAKING_SCAN_LIMIT = 8;              // 1回の検索で相手を探す待機者の数
+
+// 更新レート（実行時設定のデフォルト値と上限、Hz）
+constexpr int DEFAULT_SPECTATOR_SNAPSHOT_HZ = 10;
+constexpr int DEFAULT_PLAYER_IDLE_BROADCAST_HZ = 2;
+constexpr int DEFAULT_CHECKPOINT_HZ = 10;
+constexpr int MAX_SIMULATION_HZ = 1000;
+constexpr int MAX_SIMULATION_CATCHUP_TICKS = 5;  // これ以上遅れたらtickを捨てる
+
+// 何も動かない間にイベントループが眠る最大時間（再接続猶予などの確認用）
+constexpr int IDLE_LOOP_MAX_SLEEP_MS = 500;
+
+// ホットリスタートで起動した新プロセスの準備完了を待つ時間（過ぎたら新プロセスを止めて自分で受付を続ける）
+constexpr int HOT_RESTART_READY_TIMEOUT_MS = 5000;
+
+// ワーカープロセス（受付プロセスが接続を受けて振り分ける）
+constexpr int MAX_WORKERS = 64;
+constexpr int WORKER_ROUTE_WAIT_MS = 500;      // 受付プロセスが最初のパケット（再接続要求か）を待つ時間
+constexpr int WORKER_ROUTE_MAX_PENDING = 256;  // 最初のパケット待ちの接続の上限（超えたら待たずに振り分ける）
+
+// 管理ソケット（試合の確認・操作用のUnixドメインソケット）
+constexpr int ADMIN_COMMAND_QUEUE_SIZE = 64;      // 未処理の操作要求の上限（2の累乗）
+constexpr int ADMIN_SNAPSHOT_READ_ATTEMPTS = 64;  // 書き込み中に重なったときの読み直し回数
+constexpr int ADMIN_CLIENT_TIMEOUT_MS = 5000;     // 管理クライアントの無通信切断
+constexpr int ADMIN_LINE_MAX = 256;               // 1行の要求の最大長
 
 // テニススコア
 enum TennisPointScore {
@@ -26,6 +95,13 @@ constexpr int GAME_SCORE_INVALID = -1;
 constexpr float PLAYER_SWING_RADIUS = 5.0f;
 constexpr float SWING_ACCELERATION_THRESHOLD = 5.0f;
 
+// プレイヤーの移動
+constexpr float PLAYER_ACCELERATION = 60.0f;     // 入力方向への加速度 (m/s^2)
+constexpr float PLAYER_DECELERATION = 80.0f;     // 入力が切れたときの減速度 (m/s^2)
+constexpr float PLAYER_INPUT_HOLD_SEC = 0.05f;   // 移動入力が有効な時間（クライアントの約3フレーム）
+constexpr float PLAYER_AREA_SIDE_MARGIN = 3.0f;  // サイドラインの外へ出られる幅
+constexpr float PLAYER_AREA_BACK_MARGIN = 6.0f;  // ベースラインの後ろへ下がれる幅
+
 // ボール打撃
 constexpr float BALL_SHOT_SPEED = 20.0f;
 constexpr float BALL_SHOT_ANGLE_Y = 0.5f;
@@ -49,11 +125,42 @@ constexpr float SWING_SPEED_MAX = 25.0f;
 constexpr float BALL_SHOT_SPEED_BASE = 12.0f;
 constexpr float Z_VELOCITY_DAMPING = 2.2f;
 
+// AIプレイヤー
+constexpr float AI_DEFAULT_SKILL = 0.8f;
+constexpr float AI_MAX_MISS_CHANCE = 0.4f;    // skill 0 のときの打ち損じ確率
+constexpr float AI_SWING_REACH_RATIO = 0.8f;  // スイング半径のこの割合まで近づいたら打つ
+constexpr float AI_MOVE_DEADZONE = 0.2f;      // 目標位置との差がこれ以下なら止まる
+constexpr float AI_HOME_DEPTH_RATIO = 0.9f;   // 待機位置（ベースライン距離に対する割合）
+constexpr float AI_SERVE_WAIT_SEC = 1.0f;    // サーブ位置に着いてから打つまでの時間
+constexpr float AI_LOB_CHANCE = 0.15f;
+
+// ダブルス
+constexpr float DOUBLES_LANE_X_RATIO = 0.5f;  // 各レーンの中心（コート半幅に対する割合）
+
+// ヘッドレス実行（AI同士の試合）
+constexpr int HEADLESS_MAX_TICKS_PER_MATCH = 1000000;  // 終わらない試合の打ち切り
+constexpr float HEADLESS_FUZZ_MIN_SKILL = 0.2f;         // --fuzz で乱数化するAIの強さの下限
+constexpr int HEADLESS_EXIT_OTHER_BUILD = 77;           // 別ビルドで記録したトレースは照合しない（CTestのSKIP_RETURN_CODE）
+
 // 能力
 constexpr float ABILITY_SPEED_UP_MULTIPLIER = 2.0f;
+constexpr float ABILITY_SPEED_UP_HIT_VELOCITY_Z_SCALE = 3.0f;  // スピードアップ中の打球の前後速度
+constexpr float ABILITY_SPEED_UP_HIT_GRAVITY = 2.0f;           // スピードアップ中の打球の重力倍率
+constexpr int ABILITY_CLONE_DECOY_BALLS = 2;                  // 分身中の打球と同時に出す分身の数
+constexpr float DECOY_BALL_SPREAD_X = 3.0f;                   // 分身の本球に対する横方向の速度差
 
 // ロブショット（Bボタン）
 constexpr float LOB_SHOT_SPEED_MULTIPLIER = 1.0f;
 constexpr float LOB_SHOT_Y_BOOST = 1.7f;
 constexpr float LOB_SHOT_Z_BOOST = 0.5f;
 constexpr float LOB_SHOT_GRAVITY_MULTIPLIER = 0.8f;
+
+// コート面（バウンド時の跳ね返り係数の倍率と、水平速度の残る割合）
+// ハードコートは GameConstants::BOUNCE_RESTITUTION そのまま
+constexpr float CLAY_RESTITUTION_SCALE = 1.1f;   // 高く弾む
+constexpr float CLAY_BOUNCE_FRICTION = 0.8f;     // 球足が遅くなる
+constexpr float GRASS_RESTITUTION_SCALE = 0.8f;  // 低く滑る
+constexpr float GRASS_BOUNCE_FRICTION = 0.95f;
+
+// 試合イベント（tickの最後にまとめて配る）
+constexpr unsigned GAME_EVENT_QUEUE_SIZE = 64;  // 1試合のリングバッファの大きさ（2のべき乗）